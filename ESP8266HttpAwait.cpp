@@ -0,0 +1,114 @@
+/*
+ * C++20 coroutine interface to ESP8266HttpRead.
+ * See ESP8266HttpAwait.h for details.
+ *
+ * Copyright (c) 2015 Bradford Needham
+ * (@bneedhamia, https://www.needhamia.com)
+ * Licensed under the LGPL version 3
+ * a version of which should be supplied with this file.
+ */
+#include "ESP8266HttpAwait.h"
+
+#if defined(ESP8266HTTP_COROUTINES)
+
+ESP8266HttpAwaiter::ESP8266HttpAwaiter(ESP8266HttpEventLoop *pLoop, ESP8266HttpRead *pReader,
+    uint8_t operation, char *buf, int count, const char *pattern) {
+  _pLoop = pLoop;
+  _pReader = pReader;
+  _operation = operation;
+  _buf = buf;
+  _count = count;
+  _pattern = pattern;
+  _result = 0;
+  _pNext = 0;
+}
+
+/*
+ * Try the operation, using only the data that has already arrived.
+ * Returns true if it is done (see _result), false if it must be tried again later.
+ */
+bool ESP8266HttpAwaiter::poll() {
+  char ch;
+
+  switch (_operation) {
+  case OP_READ:
+    _result = _pReader->read(&ch, 1, 0);
+    if (_result == 1) {
+      _result = (uint8_t) ch;
+    }
+    break;
+  case OP_READ_BUF:
+    _result = _pReader->read(_buf, _count, 0);
+    break;
+  default:
+    _result = _pReader->find(_pattern, 0);
+    break;
+  }
+
+  return _result != _pReader->READ_PARTIAL;
+}
+
+/*
+ * The operation isn't done: wait in the loop's list until it is.
+ */
+void ESP8266HttpAwaiter::await_suspend(std::coroutine_handle<> handle) {
+  _handle = handle;
+  _pNext = _pLoop->_pWaiting;
+  _pLoop->_pWaiting = this;
+}
+
+/*
+ * co_await this to read one byte.
+ * Gives the byte, or a READ_* code (e.g., READ_CLOSED) as ESP8266HttpRead::read() does.
+ */
+ESP8266HttpAwaiter ESP8266HttpEventLoop::read(ESP8266HttpRead& reader) {
+  return ESP8266HttpAwaiter(this, &reader, ESP8266HttpAwaiter::OP_READ, 0, 0, 0);
+}
+
+/*
+ * co_await this to read count bytes into buf[].
+ * Gives count, or a READ_* code.
+ */
+ESP8266HttpAwaiter ESP8266HttpEventLoop::read(ESP8266HttpRead& reader, char *buf, int count) {
+  return ESP8266HttpAwaiter(this, &reader, ESP8266HttpAwaiter::OP_READ_BUF, buf, count, 0);
+}
+
+/*
+ * co_await this to read through the given pattern.
+ * Gives 1 once the pattern has been read, or a READ_* code.
+ */
+ESP8266HttpAwaiter ESP8266HttpEventLoop::find(ESP8266HttpRead& reader, const char *pattern) {
+  return ESP8266HttpAwaiter(this, &reader, ESP8266HttpAwaiter::OP_FIND, 0, 0, pattern);
+}
+
+/*
+ * Retry each waiting operation once, resuming the coroutines whose operations are done.
+ * Call this each time through loop().
+ */
+void ESP8266HttpEventLoop::run() {
+  ESP8266HttpAwaiter **ppAwaiter = &_pWaiting;
+
+  while (*ppAwaiter) {
+    ESP8266HttpAwaiter *pAwaiter = *ppAwaiter;
+    if (!pAwaiter->poll()) {
+      ppAwaiter = &pAwaiter->_pNext;
+      continue;
+    }
+
+    /*
+     * Remove it from the list before resuming: the coroutine may wait again,
+     * adding to the front of the list, or return, freeing the awaiter.
+     */
+    *ppAwaiter = pAwaiter->_pNext;
+    pAwaiter->_handle.resume();
+  }
+}
+
+/*
+ * Returns true if no coroutine is waiting.
+ */
+bool ESP8266HttpEventLoop::isIdle() {
+  return _pWaiting == 0;
+}
+
+#endif // defined(ESP8266HTTP_COROUTINES)
@@ -0,0 +1,121 @@
+#ifndef ESP8266HttpAwait_h
+#define ESP8266HttpAwait_h
+
+/*
+ * C++20 coroutine interface to ESP8266HttpRead, for compilers that have coroutines
+ * (e.g., the ESP32 or a PC; not the AVR).
+ * A coroutine can co_await a read or find instead of blocking in it,
+ * so one loop can drive many connections, each written as straight-line code,
+ * without a thread per connection.  The waiting is done by ESP8266HttpEventLoop,
+ * which retries each waiting operation, without blocking, each time ::run() is called.
+ *
+ * To use:
+ *   ESP8266HttpEventLoop events;
+ *
+ *   ESP8266HttpTask getDate(ESP8266HttpRead& reader) {
+ *     if (co_await events.find(reader, "Date: ") == 1) {
+ *       ...
+ *     }
+ *     int ch = co_await events.read(reader);
+ *     ...
+ *   }
+ *
+ *   ...start each connection, reader.begin(...), then getDate(reader);
+ *   loop():
+ *     events.run();
+ *
+ * Copyright (c) 2015 Bradford Needham
+ * (@bneedhamia, https://www.needhamia.com)
+ * Licensed under the LGPL version 3
+ * a version of which should be supplied with this file.
+ */
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#define ESP8266HTTP_COROUTINES 1
+#endif
+#endif
+
+#if defined(ESP8266HTTP_COROUTINES)
+
+#include <coroutine>
+#include <exception>  // For std::terminate()
+#include "ESP8266HttpRead.h"
+
+class ESP8266HttpEventLoop;
+
+/*
+ * The return type of a coroutine that reads with ESP8266HttpEventLoop.
+ * The coroutine starts running as soon as it is called, and frees itself when it returns.
+ */
+struct ESP8266HttpTask {
+  struct promise_type {
+    ESP8266HttpTask get_return_object() { return ESP8266HttpTask(); }
+    std::suspend_never initial_suspend() noexcept { return std::suspend_never(); }
+    std::suspend_never final_suspend() noexcept { return std::suspend_never(); }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+};
+
+/*
+ * An operation a coroutine is waiting for.  Returned by the ESP8266HttpEventLoop
+ * functions, for co_await; co_await gives the operation's result.
+ */
+class ESP8266HttpAwaiter {
+  public:
+    /*
+     * OP_* = the ESP8266HttpRead function that the awaiter calls.
+     */
+    enum Operation {
+      OP_READ,      // ::read(buf, 1, 0), for one byte.
+      OP_READ_BUF,  // ::read(buf, count, 0)
+      OP_FIND       // ::find(pattern, 0)
+    };
+
+  private:
+    friend class ESP8266HttpEventLoop;
+
+    ESP8266HttpEventLoop *_pLoop;     // the loop that retries the operation.
+    ESP8266HttpRead *_pReader;        // the reader to read from.
+    uint8_t _operation;               // what to call. See OP_*
+    char *_buf;                       // OP_READ_BUF: where to put the data.
+    int _count;                       // OP_READ_BUF: the number of bytes to read.
+    const char *_pattern;             // OP_FIND: what to find.
+    int _result;                      // the result, once the operation is done.
+    std::coroutine_handle<> _handle;  // the waiting coroutine.
+    ESP8266HttpAwaiter *_pNext;       // the next waiting operation in _pLoop's list.
+
+    bool poll();
+
+  public:
+    ESP8266HttpAwaiter(ESP8266HttpEventLoop *pLoop, ESP8266HttpRead *pReader, uint8_t operation,
+      char *buf, int count, const char *pattern);
+
+    bool await_ready() { return poll(); }
+    void await_suspend(std::coroutine_handle<> handle);
+    int await_resume() { return _result; }
+};
+
+/*
+ * Retries the operations that coroutines are waiting for, and resumes
+ * each coroutine once its operation is done.
+ * Only one coroutine at a time may use a given reader.
+ */
+class ESP8266HttpEventLoop {
+  private:
+    friend class ESP8266HttpAwaiter;
+
+    ESP8266HttpAwaiter *_pWaiting = 0;  // the operations being waited for (a linked list).
+
+  public:
+    ESP8266HttpAwaiter read(ESP8266HttpRead& reader);
+    ESP8266HttpAwaiter read(ESP8266HttpRead& reader, char *buf, int count);
+    ESP8266HttpAwaiter find(ESP8266HttpRead& reader, const char *pattern);
+    void run();
+    bool isIdle();
+};
+
+#endif // defined(ESP8266HTTP_COROUTINES)
+
+#endif // ESP8266HttpAwait_h
@@ -0,0 +1,762 @@
+/*
+ * The ESP8266 message filter used by ESP8266HttpRead.
+ * See ESP8266HttpFilter.h for details.
+ *
+ * Copyright (c) 2015 Bradford Needham
+ * (@bneedhamia, https://www.needhamia.com)
+ * Licensed under the LGPL version 3
+ * a version of which should be supplied with this file.
+ */
+#include <string.h>  // For memcpy(), memmove()
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__AVR__)
+#include <avr/pgmspace.h>  // For PROGMEM
+#else
+#define PROGMEM
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#define pgm_read_word(p) (*(const uint16_t *)(p))
+#endif
+#include "ESP8266HttpFilter.h"
+
+// (we use the default constructor for ESP8266HttpFilter)
+
+/*
+ * The text of each MSG_* message, indexed by MSG_*.
+ * A message that starts with \n also matches if \r\n starts it.
+ * Every message must start with \n or 0 (see findCommandStart()),
+ * and no message's text may start with the whole text of another.
+ * (In passive mode, +IPD and +CIPRECVDATA may also start without the \n: see ::startMatch())
+ *
+ * The recognizer is generated from this text by the compiler (see NODES[] below),
+ * so a new message needs only its text, its END_* and its MSG_*.
+ */
+static constexpr char MESSAGES[ESP8266HttpFilter::MSG_COUNT][17] PROGMEM = {
+  "\n+IPD,",
+  "0,CLOSED",
+  "0,CONNECT",
+  "\nSEND OK",
+  "\nbusy ",
+  "\nWIFI DISCONNECT",
+  "\nWIFI CONNECTED",
+  "\nWIFI GOT IP",
+  "\nOK\r\n",
+  "\nERROR\r\n",
+  "\n+CIPRECVDATA,"
+};
+
+// The most characters of text in a message.
+static const int TEXT_MAX = sizeof(MESSAGES[0]) - 1;
+
+/*
+ * END_* = what follows the text of a message, up to the end of the message.
+ */
+enum MessageEnd {
+  END_TEXT,   // nothing: the text is the whole message.
+  END_COLON,  // a length, through a ':' (or a '\n', for a message without data)
+  END_EOL     // anything, through a '\n'
+};
+
+/*
+ * The END_* of each MSG_* message, indexed by MSG_*.
+ */
+static const uint8_t MESSAGE_ENDS[ESP8266HttpFilter::MSG_COUNT] PROGMEM = {
+  END_COLON,  // MSG_IPD
+  END_TEXT,   // MSG_CLOSED
+  END_EOL,    // MSG_CONNECT
+  END_EOL,    // MSG_SEND_OK
+  END_EOL,    // MSG_BUSY
+  END_EOL,    // MSG_WIFI_DISCONNECT
+  END_EOL,    // MSG_WIFI_CONNECTED
+  END_EOL,    // MSG_WIFI_GOT_IP
+  END_TEXT,   // MSG_OK
+  END_TEXT,   // MSG_ERROR
+  END_COLON   // MSG_RECV_DATA
+};
+
+/*
+ * Compile-time functions for generating the recognizer from MESSAGES[].
+ * (C++11 constexpr functions are a single return, so the loops are recursion)
+ */
+
+// Returns true if the first length characters of text and prefix are the same.
+static constexpr bool startsWith(const char *text, const char *prefix, int length) {
+  return length == 0
+    || (text[length - 1] == prefix[length - 1] && startsWith(text, prefix, length - 1));
+}
+
+// Returns (1 << MSG_*) of each message, from message on, whose text starts with prefix[0..length-1].
+static constexpr uint16_t withPrefix(const char *prefix, int length, int message = 0) {
+  return message >= ESP8266HttpFilter::MSG_COUNT ? 0
+    : (startsWith(MESSAGES[message], prefix, length) ? (1 << message) : 0)
+      | withPrefix(prefix, length, message + 1);
+}
+
+// Returns the number of characters in text.
+static constexpr int textLength(const char *text) {
+  return *text == '\0' ? 0 : 1 + textLength(text + 1);
+}
+
+/*
+ * Returns true if none of the count messages[] starts with the whole text of another,
+ * checking each pair (messages[pair / count], messages[pair % count]) from pair on.
+ */
+static constexpr bool isPrefixFree(const char (*messages)[TEXT_MAX + 1], int count, int pair = 0) {
+  return pair >= count * count
+    || ((pair / count == pair % count
+        || !startsWith(messages[pair % count], messages[pair / count],
+          textLength(messages[pair / count])))
+      && isPrefixFree(messages, count, pair + 1));
+}
+
+/*
+ * The messages, as a trie: the messages that share the first i characters of their text
+ * share a node, whose branches are the different next characters.
+ * NODES[message][i] = (1 << MSG_*) of each message below the node that
+ * message reaches with the first i+1 characters of its text: those that start with them.
+ * ::matchNext() takes a branch by dropping the candidates that aren't below it.
+ *
+ * The table is built by the compiler, from a list of its indexes, 0 to its size - 1.
+ */
+template<int... I> struct NodeTable {
+  static const uint16_t NODES[ESP8266HttpFilter::MSG_COUNT][TEXT_MAX];
+};
+template<int... I>
+const uint16_t NodeTable<I...>::NODES[ESP8266HttpFilter::MSG_COUNT][TEXT_MAX] PROGMEM = {
+  withPrefix(MESSAGES[I / TEXT_MAX], I % TEXT_MAX + 1)...
+};
+
+template<int N, int... I> struct MakeNodeTable : MakeNodeTable<N - 1, N - 1, I...> {};
+template<int... I> struct MakeNodeTable<0, I...> {
+  typedef NodeTable<I...> type;
+};
+
+typedef MakeNodeTable<ESP8266HttpFilter::MSG_COUNT * TEXT_MAX>::type Trie;
+
+/*
+ * (1 << MSG_*) of the messages that start with \n, of those that start with 0,
+ * and of those that start with \n+ (which can start without the \n in passive mode).
+ */
+static constexpr uint16_t NL_MESSAGES = withPrefix("\n", 1);
+static constexpr uint16_t ZERO_MESSAGES = withPrefix("0", 1);
+static constexpr uint16_t PLUS_MESSAGES = withPrefix("\n+", 2);
+
+static_assert((NL_MESSAGES | ZERO_MESSAGES) == (1 << ESP8266HttpFilter::MSG_COUNT) - 1,
+  "Each message must start with \\n or 0");
+static_assert(isPrefixFree(MESSAGES, ESP8266HttpFilter::MSG_COUNT),
+  "No message's text may start with the text of another");
+
+/*
+ * (1 << MSG_*) of the messages that start with 0 but only at the start of a line.
+ * (0,CLOSED can follow a frame's data directly)
+ */
+static const uint16_t LINE_START_MESSAGES =
+  (1 << ESP8266HttpFilter::MSG_CONNECT);
+
+/*
+ * (1 << MSG_*) of the messages that the ESP8266 sends only between +IPD frames,
+ * never inside a frame's data.  Within the data (see ::isInFrame()) these are
+ * response text that happens to look like a message (e.g., a line "busy person here"),
+ * or a line "ERROR" that would end the data, so they aren't recognized there.
+ * (+IPD and 0,CLOSED are recognized anywhere, so that a frame that lost bytes
+ * still ends: see ::badFrames())
+ */
+static const uint16_t BETWEEN_FRAME_MESSAGES =
+  (1 << ESP8266HttpFilter::MSG_CONNECT)
+  | (1 << ESP8266HttpFilter::MSG_SEND_OK)
+  | (1 << ESP8266HttpFilter::MSG_BUSY)
+  | (1 << ESP8266HttpFilter::MSG_WIFI_DISCONNECT)
+  | (1 << ESP8266HttpFilter::MSG_WIFI_CONNECTED)
+  | (1 << ESP8266HttpFilter::MSG_WIFI_GOT_IP)
+  | (1 << ESP8266HttpFilter::MSG_OK)
+  | (1 << ESP8266HttpFilter::MSG_ERROR);
+
+/*
+ * (1 << MSG_*) of the messages that passive mode recognizes, whatever ::setMessages() says:
+ * the framing of the responses to AT+CIPRECVDATA.
+ */
+static const uint16_t PASSIVE_MESSAGES =
+  (1 << ESP8266HttpFilter::MSG_OK)
+  | (1 << ESP8266HttpFilter::MSG_ERROR)
+  | (1 << ESP8266HttpFilter::MSG_RECV_DATA);
+
+/*
+ * Reset the filter to the start of a new Http response.
+ */
+void ESP8266HttpFilter::begin() {
+  _cmdState = CMD_WAIT;
+  _nextIn = 0;
+  _nextOut = 0;
+  _flushEnd = 0;
+  _status = FILTER_OK;
+  _lastCh = '\n';  // (the data starts a line)
+  _awaiting = false;
+  _closePending = false;
+  _frameExpected = 0;
+  _frameReceived = 0;
+  _badFrames = 0;
+}
+
+/*
+ * Choose which messages to recognize and remove.
+ * messageMask = the OR of (1 << ESP8266HttpFilter::MSG_*) of each message.
+ *   The default is ESP8266HttpFilter::MSG_DEFAULT.
+ */
+void ESP8266HttpFilter::setMessages(uint16_t messageMask) {
+  _enabled = messageMask;
+}
+
+/*
+ * Set a function to call each time the filter recognizes and removes a message.
+ * pHandler = the function to call, or null to call nothing.
+ * pContext = passed to pHandler, for example a pointer to the caller's object.
+ */
+void ESP8266HttpFilter::onMessage(MessageHandler pHandler, void *pContext) {
+  _pHandler = pHandler;
+  _pHandlerContext = pContext;
+}
+
+/*
+ * Returns the length given in the last +IPD or +CIPRECVDATA message:
+ * the number of bytes of data that follow it.
+ * For example, call this from the ::onMessage() function.
+ */
+unsigned int ESP8266HttpFilter::frameLength() {
+  return _frameLength;
+}
+
+/*
+ * Choose passive receive mode, where the ESP8266 (after AT+CIPRECVMODE=1) holds
+ * the received data until asked for it with AT+CIPRECVDATA, or the usual active mode.
+ *
+ * In passive mode only the data of +CIPRECVDATA responses is returned.
+ * That data is passed through whole, without looking for messages in it,
+ * and everything else the ESP8266 sends (e.g., the echo of the AT command) is discarded.
+ * Because the ESP8266 may still hold data when the connection closes,
+ * 0,CLOSED ends the data only once a request returns no data.
+ *
+ * Call ::expectResponse(true) after sending each AT+CIPRECVDATA.
+ */
+void ESP8266HttpFilter::setPassive(bool passive) {
+  _passive = passive;
+}
+
+/*
+ * Passive mode: say whether an AT+CIPRECVDATA request has been sent
+ * whose response hasn't finished arriving.
+ * expect = true after sending a request; false to give up on the response.
+ */
+void ESP8266HttpFilter::expectResponse(bool expect) {
+  _awaiting = expect;
+}
+
+/*
+ * Passive mode: returns true if the response to the last AT+CIPRECVDATA
+ * hasn't finished arriving, so it isn't yet time to send another.
+ */
+bool ESP8266HttpFilter::isAwaitingResponse() {
+  return _awaiting;
+}
+
+/*
+ * Return the next byte of filtered data, if there is one.
+ *
+ * Returns:
+ *   >= 0 = the next byte from the Http response.
+ *   ESP8266HttpFilter::FILTER_EMPTY = no more filtered data is available
+ *     until the next ::put().
+ */
+int ESP8266HttpFilter::get() {
+  if (_nextOut < _flushEnd) {
+    ++_frameReceived;
+    return (uint8_t) _cmdBuf[_nextOut++];
+  }
+  return FILTER_EMPTY;
+}
+
+/*
+ * Filter a span of bytes received from the ESP8266.
+ * This is the same as calling ::put() for each byte of in[]
+ * and ::get() until it returns FILTER_EMPTY,
+ * without the per-byte call overhead.
+ *
+ * in[] = the bytes received from the ESP8266.
+ * inCount = the number of bytes in in[].
+ * out[] = receives the filtered Http response bytes.
+ * outSize = the size of out[].
+ * pInUsed = if not null, receives the number of bytes of in[] that were consumed.
+ *   That is less than inCount if out[] filled up or the data ended (see ::status()).
+ *
+ * Returns the number of bytes stored in out[].
+ */
+size_t ESP8266HttpFilter::filter(const char *in, size_t inCount, char *out, size_t outSize, size_t *pInUsed) {
+  size_t nextIn = 0;
+  size_t nextOut = 0;
+
+  while (nextOut < outSize) {
+    int ch = get();
+    if (ch >= 0) {
+      out[nextOut++] = (char) ch;
+      continue;
+    }
+    if (_status != FILTER_OK || nextIn >= inCount) {
+      break;
+    }
+
+    // The requested data in passive mode is copied whole.
+    if (_cmdState == CMD_PAYLOAD) {
+      size_t count = inCount - nextIn;
+      if (count > outSize - nextOut) {
+        count = outSize - nextOut;
+      }
+      if (count > _payloadLeft) {
+        count = _payloadLeft;
+      }
+      memcpy(&out[nextOut], &in[nextIn], count);
+      nextIn += count;
+      nextOut += count;
+      _payloadLeft -= count;
+      if (_payloadLeft == 0) {
+        _cmdState = CMD_WAIT;
+      }
+      continue;
+    }
+
+    /*
+     * Outside of a command, only '\r', '\n' or '0' can start one,
+     * so copy everything before the next of those straight to out[].
+     * (In passive mode, that's discarded: see ::put())
+     */
+    if (_cmdState == CMD_WAIT && !_passive) {
+      size_t count = inCount - nextIn;
+      if (count > outSize - nextOut) {
+        count = outSize - nextOut;
+      }
+      const char *pStart = &in[nextIn];
+      count = findCommandStart(pStart, pStart + count) - pStart;
+      if (count > 0) {
+        memcpy(&out[nextOut], pStart, count);
+        nextIn += count;
+        nextOut += count;
+        _frameReceived += count;
+        _lastCh = pStart[count - 1];
+        continue;
+      }
+    }
+
+    put(in[nextIn++]);
+  }
+
+  if (pInUsed) {
+    *pInUsed = nextIn;
+  }
+  return nextOut;
+}
+
+/*
+ * Returns true if the data has ended since ::begin():
+ * the connection has closed, or failed.  See ::status().
+ */
+bool ESP8266HttpFilter::isClosed() {
+  return _status != FILTER_OK;
+}
+
+/*
+ * Returns:
+ *   ESP8266HttpFilter::FILTER_OK = the data hasn't ended.
+ *   ESP8266HttpFilter::FILTER_CLOSED = "0,CLOSED" has been received.
+ *   ESP8266HttpFilter::FILTER_DISCONNECTED = "WIFI DISCONNECT" has been received.
+ *   ESP8266HttpFilter::FILTER_LINK_ERROR = "ERROR" has been received.
+ */
+int ESP8266HttpFilter::status() {
+  return _status;
+}
+
+/*
+ * Returns the number of +IPD frames, since ::begin(), whose data didn't match
+ * the length the +IPD gave: a frame that ended early (usually because bytes were lost,
+ * for example by SoftwareSerial overflowing), or that grew (usually because bytes of
+ * the next +IPD were lost, so it wasn't recognized and became data).
+ * The data of such a frame can't be trusted.
+ * (Passive mode, whose frames are read by length, doesn't count these.)
+ */
+unsigned int ESP8266HttpFilter::badFrames() {
+  return _badFrames;
+}
+
+/*
+ * Give up on any partly-received message: treat it as data,
+ * so that ::get() returns it.
+ * Call this when no more input has arrived for a while:
+ * the ESP8266 sends each message all at once, so a message that stops partway
+ * is really response data that happens to look like the start of a message,
+ * for example a response that ends with "\r\n".
+ *
+ * Returns true if there was a partly-received message.
+ */
+bool ESP8266HttpFilter::flush() {
+  if (_cmdState == CMD_WAIT || _cmdState == CMD_PAYLOAD) {
+    return false;   // (a payload is data, known by its length, even if it pauses)
+  }
+  _flushEnd = _nextIn;
+  _cmdState = CMD_WAIT;
+  if (_passive) {
+    _nextOut = _flushEnd;  // (not requested data)
+  }
+  return true;
+}
+
+/*
+ * Pass the next byte received from the ESP8266 through the filter.
+ * Call ::get() afterward until it returns FILTER_EMPTY, to retrieve
+ * any Http response bytes that are now known not to be part of a message.
+ * (::get() must return FILTER_EMPTY before the next ::put())
+ *
+ * Returns:
+ *   ESP8266HttpFilter::FILTER_OK = the byte was accepted.
+ *   ESP8266HttpFilter::FILTER_CLOSED = the byte completed "0,CLOSED".
+ *   ESP8266HttpFilter::FILTER_DISCONNECTED = the byte completed "WIFI DISCONNECT".
+ *   ESP8266HttpFilter::FILTER_LINK_ERROR = the byte completed "ERROR".
+ *
+ * The ESP8266 inserts communication about the data transfer
+ * into the data transfer itself.
+ * For example, the string "\r\n+IPD,0,1475:" can appear anywhere in the data
+ * and the string "0,CLOSED" appears at the end.
+ * See MESSAGES[] for the messages that are recognized.
+ */
+int ESP8266HttpFilter::put(char ch) {
+
+  // Once get() has returned the data, move any possible message to the start of _cmdBuf[]
+  if (_nextOut >= _flushEnd && _flushEnd > 0) {
+    memmove(_cmdBuf, &_cmdBuf[_flushEnd], _nextIn - _flushEnd);
+    _nextIn -= _flushEnd;
+    _nextOut = 0;
+    _flushEnd = 0;
+  }
+  if (_nextIn >= sizeof(_cmdBuf)) {
+    // get() wasn't called. Discard the data rather than overrun _cmdBuf[].
+    _nextIn = 0;
+    _nextOut = 0;
+    _flushEnd = 0;
+    _cmdState = CMD_WAIT;
+  }
+
+  _cmdBuf[_nextIn++] = ch;
+
+  if (_cmdState == CMD_PAYLOAD) {
+    _flushEnd = _nextIn;
+    if (--_payloadLeft == 0) {
+      _cmdState = CMD_WAIT;
+    }
+    return FILTER_OK;
+  }
+
+  /*
+   * This is a state machine: the current state (CMD_*) and the input character
+   * together determine the new state.
+   */
+
+  int result = FILTER_OK;
+  switch (_cmdState) {
+  case CMD_WAIT:
+    startMatch(ch);
+    break;
+
+  case CMD_CR:
+    // \r\n may start a message. \r followed by anything else is data.
+    if (ch != '\n') {
+      _cmdState = CMD_WAIT;
+    }
+    startMatch(ch);
+    break;
+
+  case CMD_MATCH:
+    result = matchNext(ch);
+    break;
+
+  case CMD_TO_COLON:
+    // The length is the last number before the ':'. E.g., +IPD,0,1460:
+    if (ch >= '0' && ch <= '9') {
+      _frameLength = _frameLength * 10 + (ch - '0');
+    } else if (ch == ',') {
+      _frameLength = 0;
+    } else if (ch == ':' || ch == '\n') {
+      result = endMessage(_message);
+    }
+    break;
+
+  case CMD_TO_EOL:
+    if (ch == '\n') {
+      result = endMessage(_message);
+    }
+    break;
+
+  default:
+    break;
+  }
+
+  // If the end of a message hasn't appeared by the time _cmdBuf[] is full, it wasn't a message.
+  if (_nextIn >= sizeof(_cmdBuf) && _cmdState != CMD_WAIT && _cmdState != CMD_PAYLOAD) {
+    _flushEnd = _nextIn;
+    _cmdState = CMD_WAIT;
+  }
+
+  // In passive mode, data that isn't in a +CIPRECVDATA response is discarded.
+  if (_passive && _cmdState != CMD_PAYLOAD) {
+    _nextOut = _flushEnd;
+  }
+
+  _lastCh = ch;
+  return result;
+}
+
+/*
+ * Part of the message recognition state machine.
+ * ch, the last character in _cmdBuf[], is not part of a message matched so far.
+ * See whether it starts one.
+ */
+void ESP8266HttpFilter::startMatch(char ch) {
+  if (ch == '\r') {
+    _flushEnd = _nextIn - 1;  // (a \r before this one is data)
+    _cmdState = CMD_CR;
+    return;
+  }
+
+  uint16_t enabled = _enabled;
+  if (_passive) {
+    enabled |= PASSIVE_MESSAGES;
+  } else if (isInFrame()) {
+    enabled &= ~BETWEEN_FRAME_MESSAGES;
+  }
+
+  uint16_t candidates;
+  uint_fast8_t matchLength = 1;
+  if (ch == '\n') {
+    candidates = enabled & NL_MESSAGES;
+  } else if (ch == '0') {
+    candidates = enabled & ZERO_MESSAGES;
+    if (_lastCh != '\n') {
+      candidates &= ~LINE_START_MESSAGES;
+    }
+  } else if (ch == '+' && _passive) {
+    // With the ESP8266's echo turned off, a response may start without the \r\n.
+    candidates = enabled & PLUS_MESSAGES;
+    matchLength = 2;
+  } else {
+    candidates = 0;
+  }
+
+  if (!candidates) {
+    // ch (and any \r before it) is data.
+    _flushEnd = _nextIn;
+    _cmdState = CMD_WAIT;
+    return;
+  }
+
+  if (_cmdState != CMD_CR) {
+    _flushEnd = _nextIn - 1;
+  } // else the \r before the \n is part of the message.
+  _candidates = candidates;
+  _matchLength = matchLength;
+  _cmdState = CMD_MATCH;
+}
+
+/*
+ * Part of the message recognition state machine.
+ * Given the next character, ch, narrow down which messages might be arriving:
+ * take the branch of the trie (see NODES[]) that ch leads to.
+ * Returns the value for ::put() to return.
+ */
+int ESP8266HttpFilter::matchNext(char ch) {
+  uint16_t candidates = _candidates;
+  uint16_t below = 0;
+  uint_fast8_t message = 0;
+
+  // Each branch is tried once, through the first candidate below it.
+  while (candidates) {
+    message = __builtin_ctz(candidates);
+    below = pgm_read_word(&Trie::NODES[message][_matchLength]);
+    if ((char) pgm_read_byte(&MESSAGES[message][_matchLength]) == ch) {
+      break;
+    }
+    candidates &= ~below;
+  }
+
+  if (!candidates) {
+    // Not a message after all. The text before ch is data; ch might start a message.
+    _cmdState = CMD_WAIT;
+    startMatch(ch);
+    return FILTER_OK;
+  }
+
+  _candidates = candidates & below;
+  ++_matchLength;
+
+  /*
+   * If we've received all the text of a message, skip the rest of it.
+   * (No message's text starts with another's, so it is the only candidate left)
+   */
+  if (pgm_read_byte(&MESSAGES[message][_matchLength]) != '\0') {
+    return FILTER_OK;
+  }
+
+  switch (pgm_read_byte(&MESSAGE_ENDS[message])) {
+  case END_COLON:
+    _message = message;
+    _frameLength = 0;
+    _cmdState = CMD_TO_COLON;
+    break;
+  case END_EOL:
+    _message = message;
+    _cmdState = CMD_TO_EOL;
+    break;
+  default:
+    return endMessage(message);
+  }
+
+  return FILTER_OK;
+}
+
+/*
+ * Part of the message recognition state machine.
+ * The whole of the given message (MSG_*) has been received.  Remove it from the data.
+ * Returns the value for ::put() to return.
+ */
+int ESP8266HttpFilter::endMessage(uint_fast8_t message) {
+  _nextIn = _flushEnd;
+  _cmdState = CMD_WAIT;
+
+  if (!_passive && (message == MSG_IPD || message == MSG_CLOSED)) {
+    checkFrame(message == MSG_IPD ? _frameLength : 0);
+  }
+
+  if (_pHandler) {
+    (*_pHandler)(message, _pHandlerContext);
+  }
+
+  /*
+   * 0,CLOSED: the ESP8266 has finished sending data from the server.
+   * WIFI DISCONNECT or ERROR: no more data is coming, so say so now
+   * rather than letting the caller wait for a timeout.
+   * In passive mode, the ESP8266 may still hold data after 0,CLOSED:
+   * the data ends when a request returns none (or fails, now the connection is gone).
+   */
+  switch (message) {
+  case MSG_CLOSED:
+    if (_passive) {
+      _closePending = true;
+      return FILTER_OK;
+    }
+    _status = FILTER_CLOSED;
+    break;
+  case MSG_WIFI_DISCONNECT:
+    _status = FILTER_DISCONNECTED;
+    break;
+  case MSG_ERROR:
+    _awaiting = false;
+    _status = _closePending ? FILTER_CLOSED : FILTER_LINK_ERROR;
+    break;
+  case MSG_OK:
+    _awaiting = false;
+    return FILTER_OK;
+  case MSG_RECV_DATA:
+    if (_frameLength > 0) {
+      _payloadLeft = _frameLength;
+      _cmdState = CMD_PAYLOAD;
+      return FILTER_OK;
+    }
+    if (!_closePending) {
+      return FILTER_OK;
+    }
+    _status = FILTER_CLOSED;
+    break;
+  default:
+    return FILTER_OK;
+  }
+  return _status;
+}
+
+/*
+ * Part of the message recognition state machine.
+ * The current +IPD frame has ended, with a new +IPD or 0,CLOSED.
+ * Count it if its data didn't match its length, then start counting the next frame.
+ * nextLength = the length of the next frame, or 0 if there isn't one.
+ */
+void ESP8266HttpFilter::checkFrame(uint16_t nextLength) {
+  // The frame's data that ::get() hasn't returned yet counts as received.
+  uint16_t pending = _flushEnd - _nextOut;
+
+  if (_frameExpected != 0 && (uint16_t) (_frameReceived + pending) != _frameExpected) {
+    ++_badFrames;
+  }
+
+  // ::get() will count the pending data again, so start the next frame's count below zero.
+  _frameExpected = nextLength;
+  _frameReceived = -pending;
+}
+
+/*
+ * Part of the message recognition state machine.
+ * Returns true if a message starting at the character just received
+ * (or at the \r before it, in CMD_CR) would be inside the data of the current +IPD frame.
+ */
+bool ESP8266HttpFilter::isInFrame() {
+  if (_frameExpected == 0) {
+    return false;   // no +IPD yet.
+  }
+
+  // The frame's data before the message: that returned, and that ::get() hasn't returned yet.
+  uint_fast8_t start = _nextIn - (_cmdState == CMD_CR ? 2 : 1);
+  return (uint16_t) (_frameReceived + (start - _nextOut)) < _frameExpected;
+}
+
+/*
+ * Returns a pointer to the first '\r', '\n' or '0' in p[] (the characters
+ * that can start an ESP8266 message), or pEnd if there is none.
+ *
+ * On processors that have them, this examines 16 bytes at a time (SSE2)
+ * or a word at a time; on 8-bit processors such as the AVR it examines
+ * a byte at a time.
+ */
+const char *ESP8266HttpFilter::findCommandStart(const char *p, const char *pEnd) {
+#if defined(__SSE2__)
+  const __m128i returns = _mm_set1_epi8('\r');
+  const __m128i newlines = _mm_set1_epi8('\n');
+  const __m128i zeros = _mm_set1_epi8('0');
+  while (pEnd - p >= 16) {
+    __m128i chunk = _mm_loadu_si128((const __m128i *) p);
+    int found = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, returns),
+      _mm_or_si128(_mm_cmpeq_epi8(chunk, newlines), _mm_cmpeq_epi8(chunk, zeros))));
+    if (found) {
+      return p + __builtin_ctz(found);
+    }
+    p += 16;
+  }
+#elif UINTPTR_MAX > 0xFFFF
+  /*
+   * A byte of word w is zero exactly when the same byte of
+   * (w - 0x0101...) & ~w & 0x8080... has its high bit set.
+   */
+  const uintptr_t ones = ((uintptr_t) -1) / 0xFF;
+  const uintptr_t highs = ones * 0x80;
+  while (pEnd - p >= (ptrdiff_t) sizeof(uintptr_t)) {
+    uintptr_t word;
+    memcpy(&word, p, sizeof(word));
+    uintptr_t returns = word ^ (ones * '\r');
+    uintptr_t newlines = word ^ (ones * '\n');
+    uintptr_t zeros = word ^ (ones * '0');
+    if (((returns - ones) & ~returns & highs)
+        | ((newlines - ones) & ~newlines & highs)
+        | ((zeros - ones) & ~zeros & highs)) {
+      break;  // it's in this word. Find it below.
+    }
+    p += sizeof(uintptr_t);
+  }
+#endif
+
+  while (p < pEnd && *p != '\r' && *p != '\n' && *p != '0') {
+    ++p;
+  }
+  return p;
+}
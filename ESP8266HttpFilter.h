@@ -0,0 +1,168 @@
+#ifndef ESP8266HttpFilter_h
+#define ESP8266HttpFilter_h
+
+/*
+ * The ESP8266 message filter used by ESP8266HttpRead.
+ * The filter recognizes and removes the transfer messages that the
+ * Sparkfun ESP8266 WiFi Shield inserts into the received data.
+ * It knows nothing about where the data comes from,
+ * so it can be used off the Arduino, for example to clean up
+ * captured serial traces on a PC.
+ *
+ * Copyright (c) 2015 Bradford Needham
+ * (@bneedhamia, https://www.needhamia.com)
+ * Licensed under the LGPL version 3
+ * a version of which should be supplied with this file.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * To use:
+ *   ESP8266HttpFilter filter;
+ *   filter.begin();
+ *   ...
+ *   for each byte received from the ESP8266:
+ *     if (filter.put(ch) < 0) {
+ *       ...the connection has closed (FILTER_CLOSED) or failed.
+ *     }
+ *     while ((ch = filter.get()) >= 0) {
+ *       ...ch is the next byte of the Http response.
+ *     }
+ *
+ * or, for data that is already in memory (e.g., a file read on a PC):
+ *   outCount = filter.filter(in, inCount, out, outSize, &inUsed);
+ *   ...out[0..outCount-1] is the Http response.
+ *   ...repeat with in += inUsed, inCount -= inUsed until inCount == 0 or filter.isClosed().
+ *
+ * In passive receive mode (AT+CIPRECVMODE=1) the ESP8266 holds the received data
+ * until it is asked for it with AT+CIPRECVDATA.  See ::setPassive().
+ */
+class ESP8266HttpFilter {
+  public:
+    /*
+     * MSG_* = the messages from the ESP8266 that the filter recognizes and removes.
+     * See MESSAGES[] in ESP8266HttpFilter.cpp for the text of each.
+     * Use (1 << MSG_*) to build the mask for ::setMessages().
+     */
+    enum Message {
+      MSG_IPD,              // \r\n+IPD,...: = data follows
+      MSG_CLOSED,           // 0,CLOSED = the connection has been closed.
+      MSG_CONNECT,          // 0,CONNECT (at the start of a line) = the connection has been opened.
+      MSG_SEND_OK,          // \r\nSEND OK = the request has been sent.
+      MSG_BUSY,             // \r\nbusy p... or busy s... = the ESP8266 is busy.
+      MSG_WIFI_DISCONNECT,  // \r\nWIFI DISCONNECT = the WiFi connection dropped.
+      MSG_WIFI_CONNECTED,   // \r\nWIFI CONNECTED
+      MSG_WIFI_GOT_IP,      // \r\nWIFI GOT IP
+      MSG_OK,               // \r\nOK\r\n  (off by default: a response body line could be "OK")
+      MSG_ERROR,            // \r\nERROR\r\n = the link failed.
+      MSG_RECV_DATA,        // \r\n+CIPRECVDATA,...: = requested data follows (passive mode)
+      MSG_COUNT             // (the number of messages)
+    };
+
+    // The messages recognized unless ::setMessages() says otherwise.
+    static const uint16_t MSG_DEFAULT = ((1 << MSG_COUNT) - 1) & ~(1 << MSG_OK);
+
+    /*
+     * Function to call when a message is recognized and removed.
+     * message = the MSG_* that was received.
+     * pContext = the pContext passed to ::onMessage().
+     */
+    typedef void (*MessageHandler)(uint_fast8_t message, void *pContext);
+
+    /*
+     * The most bytes the filter holds back at a time (as a possible message).
+     * ::filter() can return up to this many more bytes than it was given.
+     */
+    static const int HELD_MAX = 24;
+
+  private:
+    /*
+     * CMD_* = state machine state for ESP8266 messages in the input stream.
+     * The text of the messages is in MESSAGES[], rather than in the states.
+     */
+    enum CmdState {
+      CMD_WAIT,     // Waiting for a message from the ESP8266
+      CMD_CR,       // \r has been received. Messages that start with \n may follow.
+      CMD_MATCH,    // part of the text of one or more messages has been received.
+      CMD_TO_COLON, // a message has been received; skip through the next ':'
+      CMD_TO_EOL,   // a message has been received; skip through the next '\n'
+      CMD_PAYLOAD   // passive mode: the requested data, _payloadLeft bytes of it, is arriving.
+    };
+
+    /*
+     * The uint_fast8_t fields are a byte on the AVR, to save RAM,
+     * and a full word on 32-bit processors, which handle words faster than bytes.
+     */
+    uint_fast8_t _cmdState;   // current state of the command-recognition state machine. See CMD_*
+
+    /*
+     * _cmdBuf[] holds input that might be a message, but might not.
+     * _cmdBuf[_nextOut.._flushEnd-1] is data, waiting to be returned by ::get().
+     * _cmdBuf[_flushEnd.._nextIn-1] is the possible message.
+     */
+    char _cmdBuf[HELD_MAX];
+    uint_fast8_t _nextIn;     // index of the next available space in _cmdBuf[]
+    uint_fast8_t _nextOut;    // index of the next thing to return from _cmdBuf[]
+    uint_fast8_t _flushEnd;   // index just past the data in _cmdBuf[]
+
+    uint_fast8_t _matchLength; // number of characters of the message text matched so far.
+    uint16_t _candidates;     // (1 << MSG_*) of each message that matches so far.
+    uint_fast8_t _message;    // the MSG_* being skipped in CMD_TO_COLON or CMD_TO_EOL.
+    char _lastCh;             // the byte before the one ::put() is looking at.
+    uint16_t _frameLength;    // the length given in the last +IPD or +CIPRECVDATA message.
+    uint16_t _payloadLeft;    // in CMD_PAYLOAD, the number of bytes still to arrive.
+
+    /*
+     * To detect lost bytes (e.g., SoftwareSerial overflow) in active mode,
+     * the data returned for each +IPD frame is counted against the length the +IPD gave.
+     */
+    uint16_t _frameExpected;  // length of the current +IPD frame, or 0 before the first.
+    uint16_t _frameReceived;  // bytes of the current frame returned so far.
+    uint16_t _badFrames;      // number of frames whose data didn't match their length.
+
+    uint16_t _enabled = MSG_DEFAULT;     // (1 << MSG_*) of each message to recognize.
+    MessageHandler _pHandler = 0;        // if not null, function to call per message.
+    void *_pHandlerContext = 0;          // passed to _pHandler.
+
+    int_fast8_t _status;      // FILTER_OK, or the FILTER_* of the message that ended the data.
+
+    bool _passive = false;    // if true, the data arrives only in +CIPRECVDATA responses.
+    bool _awaiting;           // passive mode: a request has been sent; its OK hasn't arrived.
+    bool _closePending;       // passive mode: 0,CLOSED has arrived, but data may be left.
+
+    void startMatch(char ch);
+    int matchNext(char ch);
+    int endMessage(uint_fast8_t message);
+    void checkFrame(uint16_t nextLength);
+    bool isInFrame();
+    static const char *findCommandStart(const char *p, const char *pEnd);
+
+  public:
+    /*
+     * Return values from ::put() and ::get().
+     */
+    static const int FILTER_LINK_ERROR = -4;   // the ESP8266 reported an error (ERROR).
+    static const int FILTER_DISCONNECTED = -3; // the WiFi connection dropped (WIFI DISCONNECT).
+    static const int FILTER_CLOSED = -2; // the ESP8266 reported the connection closed (0,CLOSED).
+    static const int FILTER_EMPTY = -1;  // no filtered data is waiting; put() more data.
+    static const int FILTER_OK = 0;      // the byte was accepted.
+
+    void begin();
+    int put(char ch);
+    int get();
+    size_t filter(const char *in, size_t inCount, char *out, size_t outSize, size_t *pInUsed);
+    bool isClosed();
+    int status();
+    bool flush();
+    void setMessages(uint16_t messageMask);
+    void onMessage(MessageHandler pHandler, void *pContext);
+    unsigned int frameLength();
+    void setPassive(bool passive);
+    void expectResponse(bool expect);
+    bool isAwaitingResponse();
+    unsigned int badFrames();
+};
+
+#endif // ESP8266HttpFilter_h
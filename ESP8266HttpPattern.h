@@ -0,0 +1,103 @@
+#ifndef ESP8266HttpPattern_h
+#define ESP8266HttpPattern_h
+
+/*
+ * Compile-time search patterns for ESP8266HttpRead::find<>().
+ * The compiler turns a pattern into code: each state of the matcher
+ * (the number of pattern characters matched so far) is a function that compares
+ * the next character against constants, using a KMP (Knuth-Morris-Pratt) failure table
+ * that is computed at compile time and then folded away.
+ * So the pattern takes no RAM, there's no pattern to walk at run time,
+ * and, unlike ESP8266HttpRead::find(const char *), a pattern that repeats part of itself
+ * (e.g., "\r\n\r\n") is found wherever it appears.
+ *
+ * To use:
+ *   ESP8266HTTP_PATTERN(HeaderEnd, "\r\n\r\n");
+ *   ...
+ *   reader.find<HeaderEnd>();
+ *
+ * Copyright (c) 2015 Bradford Needham
+ * (@bneedhamia, https://www.needhamia.com)
+ * Licensed under the LGPL version 3
+ * a version of which should be supplied with this file.
+ */
+
+#include <Arduino.h>
+
+/*
+ * Declares a pattern type, name, for the given string literal, text.
+ * The pattern must be 1 to 255 characters.
+ */
+#define ESP8266HTTP_PATTERN(name, text) \
+  struct name { \
+    static constexpr char at(int i) { return (text)[i]; } \
+    static constexpr int length() { return sizeof(text) - 1; } \
+  }
+
+/*
+ * The KMP failure function of pattern P:
+ * fail(i) = the length of the longest proper prefix of P's first i characters
+ * that is also a suffix of them.  (C++11 constexpr functions are a single return)
+ */
+template<class P> struct ESP8266HttpKmp {
+  static constexpr int fail(int i) {
+    return i <= 1 ? 0 : extend(fail(i - 1), i - 1);
+  }
+
+  // The border after border k of P[0..j) is extended by P[j], if it can be.
+  static constexpr int extend(int k, int j) {
+    return P::at(k) == P::at(j) ? k + 1 : (k == 0 ? 0 : extend(fail(k), j));
+  }
+};
+
+/*
+ * The matcher's state I: I characters of P have matched.
+ * next(ch) returns the state after ch.  Each call is a short chain
+ * of compares against constants: the failure table is used up at compile time.
+ */
+template<class P, int I, bool AT_START = (I == 0)> struct ESP8266HttpKmpState {
+  static uint_fast8_t next(char ch) {
+    return ch == P::at(I) ? I + 1 : ESP8266HttpKmpState<P, ESP8266HttpKmp<P>::fail(I)>::next(ch);
+  }
+};
+
+template<class P, int I> struct ESP8266HttpKmpState<P, I, true> {
+  static uint_fast8_t next(char ch) {
+    return ch == P::at(0) ? 1 : 0;
+  }
+};
+
+/*
+ * 0, 1, ... N-1, as template arguments, to build the table of states below.
+ */
+template<int... I> struct ESP8266HttpIndexes {};
+template<int N, int... I> struct ESP8266HttpMakeIndexes : ESP8266HttpMakeIndexes<N - 1, N - 1, I...> {};
+template<int... I> struct ESP8266HttpMakeIndexes<0, I...> {
+  typedef ESP8266HttpIndexes<I...> type;
+};
+
+/*
+ * The whole matcher: a table (in flash, on the AVR) of P's states, indexed by state.
+ */
+template<class P, class INDEXES = typename ESP8266HttpMakeIndexes<P::length()>::type>
+struct ESP8266HttpMatcher;
+
+template<class P, int... I> struct ESP8266HttpMatcher<P, ESP8266HttpIndexes<I...> > {
+  // (the state, the number of characters matched, must fit in a uint_fast8_t)
+  static_assert(P::length() >= 1 && P::length() <= 255,
+    "An ESP8266HTTP_PATTERN must be 1 to 255 characters");
+
+  typedef uint_fast8_t (*StateFunction)(char ch);
+
+  // Returns the state after ch, given the state before it.
+  static uint_fast8_t next(uint_fast8_t state, char ch) {
+    static const StateFunction STATES[] PROGMEM = { &ESP8266HttpKmpState<P, I>::next... };
+#if defined(__AVR__)
+    return ((StateFunction) pgm_read_word(&STATES[state]))(ch);
+#else
+    return STATES[state](ch);
+#endif
+  }
+};
+
+#endif // ESP8266HttpPattern_h
@@ -15,7 +15,12 @@
 #include <SoftwareSerial.h> 
 #include <SparkFunESP8266WiFi.h>
 #include <float.h>  // For DBL_MAX
+#include <limits.h> // For ULONG_MAX
+#include <ctype.h>  // For tolower(), isspace(), isdigit()
+#include <stdarg.h> // For va_list
 #include "ESP8266HttpRead.h"
+#include "ESP8266RingClient.h"
+#include "ESP8266TaskClient.h"
 
 // (we use the default constructor for ESP8266HttpRead)
 
@@ -31,14 +36,115 @@
 boolean ESP8266HttpRead::begin(ESP8266Client& esp8266Client, unsigned long timeoutMs) {
   _pEsp8266Client = &esp8266Client;
   _timeoutMs = timeoutMs;
+  _ended = false;
+  _pEsp8266Commands = 0;
+  _filtered = false;
+  _spanReads = false;
+  _pTaskClient = 0;
+  _idleMillis = millis();
+  _progress = 0;
+  _partial = false;
   
-  _cmdState = CMD_WAIT;
-  _nextIn = 0;
-  _nextOut = 0;
+  _filter.begin();
+  _filter.setPassive(false);
+  _filter.setMessages(_messages);
 
   return true;
 }
 
+/*
+ * Like ::begin(), for a client whose data has already had the ESP8266 messages
+ * removed, for example ESP8266TaskClient, which filters in a task of its own.
+ * The reader doesn't look for messages in the data, and the data ends
+ * (::read() returns READ_CLOSED) when esp8266Client.connected() returns false.
+ *
+ * Returns true.
+ */
+boolean ESP8266HttpRead::beginFiltered(ESP8266Client& esp8266Client, unsigned long timeoutMs) {
+  begin(esp8266Client, timeoutMs);
+
+  _filtered = true;
+  _filter.setMessages(0);
+
+  return true;
+}
+
+#if defined(ESP32)
+/*
+ * Like ::beginFiltered(ESP8266Client&, ...), for an ESP8266TaskClient,
+ * whose read(buf, size) the reader can use to take the data a span at a time,
+ * and whose status() says how the data ended (e.g., READ_DISCONNECTED).
+ *
+ * Returns true.
+ */
+boolean ESP8266HttpRead::beginFiltered(ESP8266TaskClient& taskClient, unsigned long timeoutMs) {
+  beginFiltered((ESP8266Client&) taskClient, timeoutMs);
+
+  _spanReads = true;
+  _pTaskClient = &taskClient;
+
+  return true;
+}
+#endif
+
+/*
+ * Like ::begin(), for an ESP8266RingClient, whose read(buf, size)
+ * the reader can use to take the data a span at a time.
+ * (The Sparkfun ESP8266Client's read(buf, size) doesn't return the number of bytes
+ * it read, so for other clients the reader takes a byte at a time)
+ *
+ * Returns true.
+ */
+boolean ESP8266HttpRead::begin(ESP8266RingClient& ringClient, unsigned long timeoutMs) {
+  begin((ESP8266Client&) ringClient, timeoutMs);
+
+  _spanReads = true;
+
+  return true;
+}
+
+/*
+ * Like ::begin(), for the ESP8266's passive receive mode.
+ * In passive mode the ESP8266 holds the data it receives until it is asked for it,
+ * so a large response can't overflow the Arduino's serial receive buffer
+ * and the Shield can run at a higher baud rate.
+ * ::read() asks for the data, frameBytes at a time, as it needs it.
+ *
+ * Before connecting to the web server, put the ESP8266 in passive mode:
+ *   esp8266.print(F("AT+CIPRECVMODE=1\r\n"));
+ * (This needs ESP8266 AT firmware 1.7 or later.)
+ *
+ * esp8266Client = the ESP8266Client you are using to contact the web server.
+ * esp8266Commands = the Stream that AT commands are sent to. E.g., esp8266.
+ * timeoutMs = time (milliseconds) that each read() will wait for a response.
+ * frameBytes = the number of bytes to ask for at a time.  Each response must fit
+ *   in the serial receive buffer along with about 30 bytes of ESP8266 framing,
+ *   so for the usual 64-byte buffer, use 32.
+ *
+ * Returns true.
+ */
+boolean ESP8266HttpRead::beginPassive(ESP8266Client& esp8266Client, Stream& esp8266Commands,
+    unsigned long timeoutMs, int frameBytes) {
+  begin(esp8266Client, timeoutMs);
+
+  _pEsp8266Commands = &esp8266Commands;
+  _frameBytes = frameBytes;
+  _filter.setPassive(true);
+
+  return true;
+}
+
+/*
+ * Passive mode: ask the ESP8266 for the next frameBytes of data (see ::beginPassive()).
+ * The library reads from connection 0, the same as 0,CLOSED.
+ */
+void ESP8266HttpRead::requestData() {
+  _pEsp8266Commands->print(F("AT+CIPRECVDATA=0,"));
+  _pEsp8266Commands->print(_frameBytes);
+  _pEsp8266Commands->print(F("\r\n"));
+  _filter.expectResponse(true);
+}
+
 /*
  * Read the next byte from the Http response read by the ESP8266,
  * skipping ESP8266 commands that appear in the response.
@@ -46,118 +152,76 @@ boolean ESP8266HttpRead::begin(ESP8266Client& esp8266Client, unsigned long timeo
  * Returns:
  *   >= 0 = the next byte from the Http response
  *   ESP8266HttpRead::READ_CLOSED = connection has been closed (0,CLOSED from the ESP8266).
+ *   ESP8266HttpRead::READ_DISCONNECTED = the WiFi connection dropped (WIFI DISCONNECT from the ESP8266).
+ *   ESP8266HttpRead::READ_LINK_ERROR = the ESP8266 reported ERROR.
  *   ESP8266HttpRead::READ_TIMEOUT = timeout occurred before a byte was received.
  *   ESP8266HttpRead::READ_ERROR = an error occurred.  Most likely, the caller didn't call ::begin().
  * 
  * This function is necessary because the ESP8266 inserts
  * communication about the data transfer into the data transfer itself.
- * For example, the string "\n+IPD,0,1475:" can appear anywhere in the data
+ * For example, the string "\r\n+IPD,0,1475:" can appear anywhere in the data
  * and the string "0,CLOSED" appears at the end.
+ * See ESP8266HttpFilter for the full list of messages that are removed.
+ *
+ * Once the connection has closed or failed, every ::read() returns
+ * the same code, without waiting, until the next ::begin().
+ * So after find(), readDouble(), etc. fail, ::read() tells why.
  */
 int ESP8266HttpRead::read() {
   if (!_pEsp8266Client) {
+    if (_ended) {
+      return READ_CLOSED;  // readStatus() gave up on the response.
+    }
     return READ_ERROR;     // begin() wasn't called first.
   }
   
   unsigned long startMillis = millis();
+  _idleMillis = startMillis;  // (the sliced functions' timeout counts from here, too)
   while (true) {
 
-    // If we're flushing _cmdBuf[], return the next character to flush.
-    if (_nextOut < _nextIn) {
-      return _cmdBuf[_nextOut++];
+    // If the filter has a character ready, return it.
+    int ch = _filter.get();
+    if (ch >= 0) {
+      return ch;
     }
 
-    // If we're not in the middle of a command, reset _cmdBuf[]
-    if (_cmdState == CMD_WAIT) {
-      _nextIn = 0;
-      _nextOut = _nextIn;
+    // If no more data is coming, say why.
+    if (_filter.isClosed()) {
+      return endCode();
     }
 
     // wait for data until it appears or we run out of time.
-    while (!_pEsp8266Client->available()) {
-      if (millis() - startMillis > _timeoutMs) {
-        return READ_TIMEOUT;
+    if (!_pEsp8266Client->available()) {
+      if (_filtered && !_pEsp8266Client->connected()) {
+        if (_filter.flush()) {
+          continue;  // return the final \r first.
+        }
+        return filteredEndCode();
       }
-      delay(1);
-    }
-    
-    _cmdBuf[_nextIn] = _pEsp8266Client->read();
-    // return _cmdBuf[_nextIn];  // DEBUG to see the raw data the board returns.
-
-    /*
-     * Recognize and skip the following commands from ESP8266:
-     * \n+IPD,...: = command that says more data is available.
-     * 0,CLOSED = the connection to the server has been closed.
-     * 
-     * This is a state machine: the current state (CMD_*) and the input character
-     * together determine the new state.
-     */
-     
-    switch (_cmdState) {
-    case CMD_WAIT:
-      if ((char) _cmdBuf[_nextIn] == '\n') {
-        ++_nextIn;
-        _nextOut = _nextIn;
-        _cmdState = CMD_NL;
-
-      } else if ((char) _cmdBuf[_nextIn] == '0') {
-        ++_nextIn;
-        _nextOut = _nextIn;
-        _cmdState = CMD_0;
-        
-      } else {
-        ++_nextIn;
-        _nextOut = 0;
-        _cmdState = CMD_WAIT;
+      if (_pEsp8266Commands && !_filter.isAwaitingResponse()) {
+        requestData();  // passive mode: data only comes when asked for.
       }
-      break;
-    case CMD_NL: advanceIf('+', CMD_PLUS); break;
-    case CMD_PLUS: advanceIf('I', CMD_I); break;
-    case CMD_I: advanceIf('P', CMD_P); break;
-    case CMD_P: advanceIf('D', CMD_D); break;
-    case CMD_D: advanceIf(',', CMD_COMMA); break;
-    case CMD_COMMA:
-      // absorb characters until a :
-      if ((char) _cmdBuf[_nextIn] != ':') {
-        ++_nextIn;
-        _nextOut = _nextIn;
-        _cmdState = CMD_COMMA;
-        break;
+      unsigned long waitMillis = millis();
+      while (!_pEsp8266Client->available()) {
+        if (millis() - waitMillis > PARTIAL_MESSAGE_MS && _filter.flush()) {
+          break;   // what looked like the start of a message was data. Return it.
+        }
+        if (millis() - startMillis > _timeoutMs) {
+          _filter.expectResponse(false);  // (passive mode: ask again next time)
+          return READ_TIMEOUT;
+        }
+        delay(1);
       }
-
-      // We've seen \n+IPD,...:  Skip that string.
-      _nextIn = 0;
-      _nextOut = 0;
-      _cmdState = CMD_WAIT;
-      break;
-
-    case CMD_0: advanceIf(',', CMD_0_); break;
-    case CMD_0_: advanceIf('C', CMD_0_C); break;
-    case CMD_0_C: advanceIf('L', CMD_0_CL); break;
-    case CMD_0_CL: advanceIf('O', CMD_0_CLO); break;
-    case CMD_0_CLO: advanceIf('S', CMD_0_CLOS); break;
-    case CMD_0_CLOS: advanceIf('E', CMD_0_CLOSE); break;
-    case CMD_0_CLOSE:
-      if ((char) _cmdBuf[_nextIn] == 'D') {
-        /*
-         * We've received the 0,CLOSED message.
-         * The ESP8266 has finished sending data from the server.
-         */
-        return READ_CLOSED;
-        
-      } else {
-        ++_nextIn;
-        _nextOut = 0;
-        _cmdState = CMD_WAIT;
+      _idleMillis = millis();
+      if (!_pEsp8266Client->available()) {
+        continue;
       }
-      break;
- 
-    default:
-      return READ_CLOSED;
     }
 
+    // Pass the data through the filter, which skips the ESP8266 commands.
+    _filter.put(_pEsp8266Client->read());
   }
-  
+
 }
 
 /*
@@ -169,20 +233,619 @@ boolean ESP8266HttpRead::read(char *buf, short count) {
   char *pEnd = &buf[count];
 
   while (pNext < pEnd) {
-    int ch = read();
-    if (ch < 0) {
+    int got = readSome(pNext, pEnd - pNext);
+    if (got < 0) {
       return false;
     }
-    *pNext++ = (char) ch;
+    pNext += got;
   }
   return true;
 }
 
+/*
+ * Reads the Http status line, e.g., "HTTP/1.1 200 OK", and returns the status code.
+ * Call this right after ::begin(), before reading any of the response.
+ * Reads through the end of the status line, so ::readHeaders(), ::findHeader(), etc.
+ * can follow.
+ *
+ * onError = what to do if the status isn't a success (2xx):
+ *   ON_ERROR_READ = nothing: the caller can read the error response.
+ *   ON_ERROR_DRAIN = read and discard the rest of the response, up to the close,
+ *     so the next request starts clean.
+ *   ON_ERROR_ABORT = close the connection right away, without reading the response.
+ *   After ON_ERROR_DRAIN or ON_ERROR_ABORT, ::read() returns READ_CLOSED, without waiting,
+ *   so a sketch's find(), readDouble(), etc. fail at once instead of timing out.
+ *
+ * Returns the status code (e.g., 200, 404), 0 if the response didn't start
+ * with a status line, or a READ_* code if the read failed.
+ *
+ * To use:
+ *   int status = reader.readStatus(reader.ON_ERROR_DRAIN);
+ *   if (status != 200) {
+ *     ...report the failure and try again later.
+ *   }
+ */
+int ESP8266HttpRead::readStatus(int onError) {
+  int status = 0;
+  int ch;
+
+  // The version: "HTTP/1.x"
+  const char *p = "HTTP/";
+  for (; *p != '\0'; ++p) {
+    ch = read();
+    if (ch < 0) {
+      return ch;
+    }
+    if ((char) ch != *p) {
+      break;
+    }
+  }
+
+  if (*p == '\0') {
+    // Skip the rest of the version, through the space.
+    do {
+      ch = read();
+    } while (ch > ' ');
+
+    // The status code.
+    while (ch == ' ') {
+      ch = read();
+    }
+    while (ch >= '0' && ch <= '9') {
+      status = status * 10 + (ch - '0');
+      ch = read();
+    }
+  }
+
+  // Skip the reason phrase.
+  if (ch >= 0 && ch != '\n') {
+    ch = skipLine();
+  }
+  if (ch < 0) {
+    return ch;
+  }
+
+  if (status < 200 || status > 299) {
+    if (onError == ON_ERROR_DRAIN) {
+      char buf[32];
+      while (readSome(buf, sizeof(buf)) >= 0) {
+      }
+      _ended = true;
+    } else if (onError == ON_ERROR_ABORT) {
+      _pEsp8266Client->stop();
+      _ended = true;
+    }
+    if (_ended) {
+      _pEsp8266Client = 0;
+    }
+  }
+
+  return status;
+}
+
+/*
+ * Reads the whole body of the Http response into buf[], followed by a '\0'.
+ * Call this right after ::begin(), before reading any of the response.
+ * Skips the status line and headers.  If there is a Content-Length header,
+ * stops right after the body instead of waiting for the connection to close.
+ *
+ * buf[] = receives the body.
+ * bufSize = the size of buf[], including room for the '\0'.
+ * pTruncated = if not null, set to true if the body didn't fit in buf[],
+ *   in which case buf[] holds the start of the body.
+ *
+ * Returns the number of bytes stored in buf[] (not counting the '\0'),
+ * or a READ_* code if the response ended early or failed
+ * (READ_ERROR, without touching buf[], if bufSize < 1).
+ *
+ * Note: chunked responses (Transfer-Encoding: chunked) are stored as they arrive,
+ * chunk sizes and all.
+ *
+ * To use:
+ *   char body[200];
+ *   boolean truncated;
+ *   int length = reader.readBody(body, sizeof(body), &truncated);
+ */
+int ESP8266HttpRead::readBody(char *buf, int bufSize, boolean *pTruncated) {
+  long contentLength;   // Content-Length, or -1 if there isn't one.
+  int result;
+
+  if (pTruncated) {
+    *pTruncated = false;
+  }
+  if (bufSize < 1) {
+    return READ_ERROR;  // no room even for the '\0'.
+  }
+  buf[0] = '\0';
+
+  result = skipHeaders(&contentLength);
+  if (result < 0) {
+    return result;
+  }
+
+  int want = bufSize - 1;
+  if (contentLength >= 0 && contentLength < want) {
+    want = (int) contentLength;
+  }
+
+  int length = 0;
+  while (length < want) {
+    result = readSome(&buf[length], want - length);
+    if (result < 0) {
+      break;
+    }
+    length += result;
+  }
+  buf[length] = '\0';
+
+  if (length < want) {
+    // Without a Content-Length, the server ends the body by closing the connection.
+    if (result == READ_CLOSED && contentLength < 0) {
+      return length;
+    }
+    return result;
+  }
+
+  if (pTruncated) {
+    if (contentLength >= 0) {
+      *pTruncated = (contentLength > length);
+    } else {
+      *pTruncated = (read() != READ_CLOSED);
+    }
+  }
+  return length;
+}
+
+/*
+ * Reads at least one and at most count bytes into buf[]:
+ * waits (per timeoutMs) for the first, then takes whatever
+ * else has already arrived, without the per-byte overhead of ::read().
+ *
+ * Returns the number of bytes stored in buf[], or a READ_* code.
+ */
+int ESP8266HttpRead::readSome(char *buf, int count) {
+  int ch = read();
+  if (ch < 0) {
+    return ch;
+  }
+  buf[0] = (char) ch;
+
+  return 1 + readWaiting(&buf[1], count - 1);
+}
+
+/*
+ * Reads up to count bytes into buf[], without waiting: only the data
+ * that has already arrived.  For callers that can't wait, such as ESP8266HttpScheduler.
+ * For example, call this each time through loop() until it returns a READ_* code.
+ *
+ * Returns the number of bytes stored in buf[] (0 if none has arrived yet), or
+ * a READ_* code if the data has ended (READ_CLOSED, when the response is complete).
+ * There is no READ_TIMEOUT: it's up to the caller to decide how long to wait.
+ */
+int ESP8266HttpRead::readAvailable(char *buf, int count) {
+  if (!_pEsp8266Client) {
+    if (_ended) {
+      return READ_CLOSED;
+    }
+    return READ_ERROR;
+  }
+
+  int length = readWaiting(buf, count);
+  if (length > 0) {
+    _idleMillis = millis();
+    return length;
+  }
+  if (_filter.isClosed()) {
+    return endCode();
+  }
+
+  // Nothing has arrived. Do what ::read() would do while it waits.
+  if (_filtered && !_pEsp8266Client->connected()) {
+    if (!_filter.flush()) {
+      return filteredEndCode();
+    }
+  } else if (millis() - _idleMillis > PARTIAL_MESSAGE_MS) {
+    _filter.flush();
+  }
+  if (_pEsp8266Commands && !_filter.isAwaitingResponse()) {
+    requestData();
+  }
+  return readWaiting(buf, count);
+}
+
+/*
+ * The time-sliced functions: ::read(buf, count, sliceMs), ::skip(), ::copyTo()
+ * and ::find(pattern, sliceMs) each work for at most about sliceMs milliseconds
+ * (0 = only on the data that has already arrived), then return READ_PARTIAL,
+ * keeping their progress in the reader.  Call the same function, with the same
+ * arguments, until it returns something else.  So a large response can be spread
+ * over many trips through loop().
+ * Call only one of them at a time: they share the progress (see ::progress()),
+ * which a call that doesn't continue a READ_PARTIAL one starts again from 0.
+ * Each returns READ_TIMEOUT if no data arrives for timeoutMs (see ::begin()).
+ *
+ * To use:
+ *   loop():
+ *     int result = reader.copyTo(file, 10);
+ *     if (result != reader.READ_PARTIAL) {
+ *       ...done: result == reader.READ_CLOSED if the whole response was copied.
+ *     }
+ */
+
+/*
+ * Reads count bytes into buf[] (see "The time-sliced functions", above).
+ * Returns count once buf[] is full, or READ_PARTIAL or a READ_* code.
+ */
+int ESP8266HttpRead::read(char *buf, int count, unsigned long sliceMs) {
+  unsigned long startMillis = millis();
+  startSliced();
+
+  while (_progress < count) {
+    int got = readAvailable(&buf[_progress], count - (int) _progress);
+    if (got == 0) {
+      got = sliceWait(startMillis, sliceMs);
+    }
+    if (got < 0) {
+      _partial = (got == READ_PARTIAL);
+      return got;
+    }
+    _progress += got;
+    if (_progress < count && millis() - startMillis >= sliceMs) {
+      _partial = true;
+      return READ_PARTIAL;
+    }
+  }
+
+  return count;
+}
+
+/*
+ * Reads and discards count bytes (see "The time-sliced functions", above).
+ * Returns 0 once they have been skipped, or READ_PARTIAL or a READ_* code.
+ */
+int ESP8266HttpRead::skip(long count, unsigned long sliceMs) {
+  unsigned long startMillis = millis();
+  startSliced();
+  char buf[32];
+
+  while (_progress < count) {
+    int want = sizeof(buf);
+    if (count - _progress < want) {
+      want = (int) (count - _progress);
+    }
+    int got = readAvailable(buf, want);
+    if (got == 0) {
+      got = sliceWait(startMillis, sliceMs);
+    }
+    if (got < 0) {
+      _partial = (got == READ_PARTIAL);
+      return got;
+    }
+    _progress += got;
+    if (_progress < count && millis() - startMillis >= sliceMs) {
+      _partial = true;
+      return READ_PARTIAL;
+    }
+  }
+
+  return 0;
+}
+
+/*
+ * Copies the rest of the response to sink, for example an SD card file
+ * (see "The time-sliced functions", above).
+ * ::progress() says how many bytes have been copied so far.
+ * Returns READ_PARTIAL, or the READ_* code that ended the data:
+ * READ_CLOSED once the whole response has been copied.
+ */
+int ESP8266HttpRead::copyTo(Print& sink, unsigned long sliceMs) {
+  unsigned long startMillis = millis();
+  startSliced();
+  char buf[32];
+
+  while (true) {
+    int got = readAvailable(buf, sizeof(buf));
+    if (got == 0) {
+      got = sliceWait(startMillis, sliceMs);
+    }
+    if (got < 0) {
+      _partial = (got == READ_PARTIAL);
+      return got;
+    }
+    sink.write((const uint8_t *) buf, got);
+    _progress += got;
+    if (millis() - startMillis >= sliceMs) {
+      _partial = true;
+      return READ_PARTIAL;
+    }
+  }
+}
+
+/*
+ * Like ::find(const char *), for at most sliceMs (see "The time-sliced functions", above).
+ * Returns 1 once the pattern has been found and read, or READ_PARTIAL or a READ_* code.
+ */
+int ESP8266HttpRead::find(const char *pattern, unsigned long sliceMs) {
+  unsigned long startMillis = millis();
+  startSliced();
+  uint8_t checkTime = 0;
+  char ch;
+
+  while (pattern[_progress] != '\0') {
+    // (checks the time every 256 bytes)
+    if (++checkTime == 0 && millis() - startMillis >= sliceMs) {
+      _partial = true;
+      return READ_PARTIAL;
+    }
+
+    // (reads a byte at a time, so as not to read past the pattern)
+    int got = readAvailable(&ch, 1);
+    if (got == 0) {
+      got = sliceWait(startMillis, sliceMs);
+      if (got == 0) {
+        continue;
+      }
+    }
+    if (got < 0) {
+      _partial = (got == READ_PARTIAL);
+      return got;
+    }
+
+    if (ch == pattern[_progress]) {
+      ++_progress;
+    } else {
+      _progress = 0;  // as in ::find(const char *), we assume no internal repetition.
+    }
+  }
+
+  return 1;
+}
+
+/*
+ * Returns how far the last time-sliced function has got:
+ * the bytes read, skipped or copied so far, or in all once it has returned.
+ * The count is kept until the next time-sliced function starts.
+ */
+long ESP8266HttpRead::progress() {
+  return _progress;
+}
+
+/*
+ * Part of the time-sliced functions: a call that doesn't continue
+ * one that returned READ_PARTIAL starts a new operation, from 0.
+ */
+void ESP8266HttpRead::startSliced() {
+  if (!_partial) {
+    _progress = 0;
+  }
+  _partial = false;
+}
+
+/*
+ * Part of the time-sliced functions: no data has arrived. Wait a little for some.
+ * Returns 0 to look again, READ_PARTIAL if the time slice has run out,
+ * or READ_TIMEOUT if no data has arrived for timeoutMs.
+ */
+int ESP8266HttpRead::sliceWait(unsigned long startMillis, unsigned long sliceMs) {
+  unsigned long now = millis();
+  if (now - _idleMillis > _timeoutMs) {
+    _filter.expectResponse(false);  // (passive mode: ask again next time)
+    return READ_TIMEOUT;
+  }
+  if (now - startMillis >= sliceMs) {
+    return READ_PARTIAL;
+  }
+  delay(1);
+  return 0;
+}
+
+/*
+ * Reads up to count bytes that have already arrived into buf[], without waiting.
+ * Returns the number of bytes stored in buf[].
+ */
+int ESP8266HttpRead::readWaiting(char *buf, int count) {
+  int length = 0;
+  while (length < count) {
+    int ch = _filter.get();
+    if (ch >= 0) {
+      buf[length++] = (char) ch;
+      continue;
+    }
+    if (_filter.isClosed()) {
+      break;
+    }
+    int waiting = _pEsp8266Client->available();
+    if (waiting <= 0) {
+      break;
+    }
+
+    /*
+     * If there's room in buf[] for what has arrived plus what the filter is holding,
+     * take it in one span, rather than a byte at a time.
+     * (Only from a client whose read(buf, size) says how much it read: see _spanReads)
+     */
+    int room = count - length - ESP8266HttpFilter::HELD_MAX;
+    if (_spanReads && waiting > 1 && room > 1) {
+      char in[32];
+      if (waiting > room) {
+        waiting = room;
+      }
+      if (waiting > (int) sizeof(in)) {
+        waiting = sizeof(in);
+      }
+      waiting = _pEsp8266Client->read((uint8_t *) in, waiting);
+      if (waiting > 0) {
+        length += _filter.filter(in, waiting, &buf[length], count - length, 0);
+        continue;
+      }
+    }
+
+    _filter.put(_pEsp8266Client->read());
+  }
+  return length;
+}
+
+/*
+ * Reads through the end of the current line.
+ * Returns '\n', or a READ_* code.
+ */
+int ESP8266HttpRead::skipLine() {
+  while (true) {
+    int ch = read();
+    if (ch < 0 || ch == '\n') {
+      return ch;
+    }
+  }
+}
+
+/*
+ * Reads through the blank line that ends the Http headers,
+ * and reports the Content-Length header.
+ * pContentLength = receives the Content-Length, or -1 if there wasn't one.
+ *
+ * Returns '\n', or a READ_* code.
+ */
+int ESP8266HttpRead::skipHeaders(long *pContentLength) {
+  char value[12];
+  HttpHeader contentLength = ESP8266HTTP_HEADER("Content-Length", value, sizeof(value));
+
+  int result = readHeaderBlock(&contentLength, 1);
+  *pContentLength = contentLength.found ? atol(value) : -1;
+  return result;
+}
+
+/*
+ * Reads the Http headers, through the blank line that ends them,
+ * saving the values of the given headers in one pass.
+ * Call this right after ::begin() (or ::readStatus()).
+ *
+ * headers[] = the headers to look for, in any order.
+ *   Declare each with ESP8266HTTP_HEADER() or ESP8266HTTP_HEADER_HANDLER();
+ *   readHeaders() sets the rest.  Header names match in any letter case.
+ * count = the number of entries in headers[].
+ *
+ * Each header's name is hashed as it arrives, so only the values
+ * of the headers you ask for are stored; the rest are skipped.
+ *
+ * Returns true if the end of the headers was reached, false otherwise (see ::read()).
+ *
+ * To use:
+ *   char type[32];
+ *   char date[32];
+ *   ESP8266HttpRead::HttpHeader headers[] = {
+ *     ESP8266HTTP_HEADER("Content-Type", type, sizeof(type)),
+ *     ESP8266HTTP_HEADER("Date", date, sizeof(date))
+ *   };
+ *   reader.readHeaders(headers, 2);
+ *   if (headers[0].found) ...
+ */
+boolean ESP8266HttpRead::readHeaders(HttpHeader *headers, int count) {
+  return readHeaderBlock(headers, count) >= 0;
+}
+
+/*
+ * Does the work of ::readHeaders().
+ * Returns '\n', or a READ_* code.
+ */
+int ESP8266HttpRead::readHeaderBlock(HttpHeader *headers, int count) {
+  HttpHeader *pHeader;
+  HttpHeader *pEnd = &headers[count];
+  int ch;
+
+  // Hash the names we're looking for.
+  for (pHeader = headers; pHeader < pEnd; ++pHeader) {
+    pHeader->found = false;
+    pHeader->hash = HASH_START;
+    pHeader->nameLength = 0;
+    for (const char *p = pHeader->name; *p != '\0'; ++p) {
+      pHeader->hash = hashNext(pHeader->hash, *p);
+      ++pHeader->nameLength;
+    }
+    if (pHeader->value && pHeader->valueSize > 0) {
+      pHeader->value[0] = '\0';
+    }
+  }
+
+  while (true) {
+
+    // Hash this line's header name, up to the ':'
+    uint32_t hash = HASH_START;
+    int nameLength = 0;
+    while (true) {
+      ch = read();
+      if (ch < 0) {
+        return ch;
+      }
+      if (ch == ':' || ch == '\n') {
+        break;
+      }
+      if (ch == '\r') {
+        continue;
+      }
+      hash = hashNext(hash, (char) ch);
+      ++nameLength;
+    }
+
+    if (ch == '\n') {
+      if (nameLength == 0) {
+        return ch;   // the blank line that ends the headers.
+      }
+      continue;      // the status line.
+    }
+
+    for (pHeader = headers; pHeader < pEnd; ++pHeader) {
+      if (pHeader->hash == hash && pHeader->nameLength == nameLength) {
+        break;
+      }
+    }
+    if (pHeader == pEnd) {
+      ch = skipLine();  // a header we don't want.
+      if (ch < 0) {
+        return ch;
+      }
+      continue;
+    }
+
+    // Store the value, without the spaces before it or the \r\n after it.
+    int length = 0;
+    ch = read();
+    while (ch == ' ' || ch == '\t') {
+      ch = read();
+    }
+    while (ch >= 0 && ch != '\n') {
+      if (ch != '\r' && pHeader->value && length < pHeader->valueSize - 1) {
+        pHeader->value[length++] = (char) ch;
+      }
+      ch = read();
+    }
+    if (ch < 0) {
+      return ch;
+    }
+    if (pHeader->value && pHeader->valueSize > 0) {
+      pHeader->value[length] = '\0';
+    }
+    pHeader->found = true;
+
+    if (pHeader->handler) {
+      (*pHeader->handler)(pHeader, pHeader->pContext);
+    }
+  }
+}
+
+/*
+ * Part of ::readHeaders(): adds the given character to the given header-name hash.
+ * Letter case is ignored, so "Date" and "date" hash the same.
+ * (This is the FNV-1a hash)
+ */
+uint32_t ESP8266HttpRead::hashNext(uint32_t hash, char ch) {
+  return (hash ^ (uint8_t) tolower((unsigned char) ch)) * 16777619UL;
+}
+
 /*
  * Like Serial.find(), but uses our ::read() instead of read().
  */
-boolean ESP8266HttpRead::find(char *ppattern) {
-  char *p = ppattern;
+boolean ESP8266HttpRead::find(const char *ppattern) {
+  const char *p = ppattern;
   int ch;
 
   while (*p != '\0') {
@@ -196,14 +859,68 @@ boolean ESP8266HttpRead::find(char *ppattern) {
       p = ppattern; // we assume no internal repetition in the input.  E.g., no "DaDate: ".
     }
   }
-  return true;
+  return true;
+}
+
+/*
+ * Skips to the given Http header and reads through the ':' after its name.
+ * The name matches in any letter case: findHeader("Date") finds "Date:", "date:" or "DATE:".
+ * Only header lines are searched: if the header isn't there,
+ * this reads through the blank line that ends the headers and returns false,
+ * rather than reading the whole body.
+ *
+ * name = the header name, without the ':'. For example, "Content-Type".
+ *
+ * Returns true if the header was found, false otherwise.
+ */
+boolean ESP8266HttpRead::findHeader(const char *name) {
+  while (true) {
+
+    // Compare the start of this line with name[], up to the ':'
+    const char *p = name;
+    boolean matches = true;
+    boolean blankLine = true;
+    int ch;
+    while (true) {
+      ch = read();
+      if (ch < 0) {
+        return false;
+      }
+      if (ch == ':' || ch == '\n') {
+        break;
+      }
+      if (ch == '\r') {
+        continue;
+      }
+      blankLine = false;
+      if (matches && *p != '\0' && tolower(ch) == tolower((unsigned char) *p)) {
+        ++p;
+      } else {
+        matches = false;
+      }
+    }
+
+    if (ch == '\n') {
+      if (blankLine) {
+        return false;  // end of the headers.
+      }
+      continue;        // the status line.
+    }
+    if (matches && *p == '\0') {
+      return true;
+    }
+    if (skipLine() < 0) {
+      return false;
+    }
+  }
 }
 
 /*
- * Skips to the "Date:" Http header
+ * Skips to the "Date:" Http header (see ::findHeader())
  * then parse the date header, through the timezone.
  * The Timezone must be GMT
  * Return true if successful, false otherwise.
+ * Call this before reading past the Http headers.
  * 
  * Example date header returned in the HTTP response from a web server:
  * Date: Fri, 21 Aug 2015 22:06:40 GMT
@@ -225,7 +942,12 @@ boolean ESP8266HttpRead::findDate(struct HttpDateTime *pDateTimeUTC) {
   pDateTimeUTC->minute = -1;
   pDateTimeUTC->second = -1;
  
-  if (!find("Date: ")) {
+  if (!findHeader("Date")) {
+    return false;
+  }
+
+  // Skip the space after "Date:"
+  if (read() < 0) {
     return false;
   }
 
@@ -438,50 +1160,710 @@ boolean ESP8266HttpRead::findDate(struct HttpDateTime *pDateTimeUTC) {
  * Returns either the decimal number, or DBL_MAX (see <float.h>) if an error occurs.
  */
 double ESP8266HttpRead::readDouble() {
-  int ch;
+  Mantissa mantissa;
+  int exponent;
+
+  int ch = read();
+  if (!readDigits(&ch, true, &mantissa, &exponent) || ch < 0) {
+    return DBL_MAX;    // no number was found at all, or early end of file or error.
+  }
+
+  return scaleMantissa(mantissa, exponent);
+}
+
+/*
+ * Read values from the input as the given format describes, in one pass.
+ * For example, for the line "T=21.4;H=55;P=1013.2":
+ *   float t, p;
+ *   int h;
+ *   if (reader.readf("T=%f;H=%d;P=%f", &t, &h, &p) == 3) ...
+ *
+ * The format is a subset of scanf()'s:
+ *   %d, %ld = an optionally signed decimal integer, into an int or long.
+ *   %u, %lu = an unsigned decimal integer, into an unsigned int or unsigned long.
+ *   %f, %lf = an optionally signed decimal number, as readDouble() reads it,
+ *     into a float or double.
+ *   %c = the next character, into a char.
+ *   %*d etc. = read the value, but don't store it.
+ *   %% = a '%' character.
+ *   white space = any amount of white space, including none.  (Numbers skip
+ *     the white space before them anyway)
+ *   any other character = that character.
+ * The compiler checks the arguments against the format, as it does for scanf().
+ *
+ * Reading stops at the first character that doesn't match the format, so a line
+ * that isn't the expected one costs no more than the characters up to the difference.
+ * That character has been read.  As with readDouble(), so has the character
+ * just past a number that ends the format.
+ *
+ * Returns the number of values stored.  If that is less than the format asks for,
+ * the input didn't match the format, or ended (see ::read()).
+ */
+int ESP8266HttpRead::readf(const char *format, ...) {
+  va_list args;
+  int stored = 0;
+  int ch = 0;
+  boolean pending = false;  // if true, ch has been read but not yet matched.
+
+  va_start(args, format);
+  for (const char *p = format; *p != '\0'; ++p) {
+    if (!pending) {
+      ch = read();
+      pending = true;
+    }
+    if (ch < 0) {
+      break;    // early end of file or error.
+    }
+
+    if (isspace(*p)) {
+      while (ch >= 0 && isspace(ch)) {
+        ch = read();
+      }
+      continue;
+    }
+
+    if (*p != '%' || *++p == '%') {
+      if ((char) ch != *p) {
+        break;  // the input doesn't match the format.
+      }
+      pending = false;
+      continue;
+    }
+
+    // A conversion: %[*][l]c
+    boolean store = true;
+    if (*p == '*') {
+      store = false;
+      ++p;
+    }
+    boolean isLong = false;
+    if (*p == 'l') {
+      isLong = true;
+      ++p;
+    }
+
+    if (*p == 'c') {
+      if (store) {
+        *va_arg(args, char *) = (char) ch;
+        ++stored;
+      }
+      pending = false;
+      continue;
+    }
+    if (*p != 'd' && *p != 'u' && *p != 'f') {
+      break;    // not a conversion we support.
+    }
+
+    while (ch >= 0 && isspace(ch)) {
+      ch = read();
+    }
+    boolean negative = false;
+    if ((ch == '-' || ch == '+') && *p != 'u') {
+      negative = (ch == '-');
+      ch = read();
+    }
+
+    Mantissa mantissa;
+    int exponent;
+    if (!readDigits(&ch, *p == 'f', &mantissa, &exponent)) {
+      break;    // no number.
+    }
+    // ch, the character after the number, is yet to be matched.
+
+    if (*p == 'f') {
+      double value = scaleMantissa(mantissa, exponent);
+      if (negative) {
+        value = -value;
+      }
+      if (store && isLong) {
+        *va_arg(args, double *) = value;
+      } else if (store) {
+        *va_arg(args, float *) = (float) value;
+      }
+    } else if (exponent != 0 || (unsigned long) mantissa != mantissa) {
+      break;    // the integer is too big.
+    } else if (*p == 'u') {
+      if (store && isLong) {
+        *va_arg(args, unsigned long *) = mantissa;
+      } else if (store) {
+        *va_arg(args, unsigned int *) = (unsigned int) mantissa;
+      }
+    } else {
+      long value = negative ? -(long) mantissa : (long) mantissa;
+      if (store && isLong) {
+        *va_arg(args, long *) = value;
+      } else if (store) {
+        *va_arg(args, int *) = (int) value;
+      }
+    }
+    if (store) {
+      ++stored;
+    }
+  }
+  va_end(args);
+
+  return stored;
+}
+
+/*
+ * Read the digits of an unsigned decimal number, such as
+ * 34
+ * 15.
+ * 90.54
+ * .2
+ * for readDouble() and readf().
+ *
+ * pCh = points to the number's first character, already read.
+ *   Receives the character just past the number, or a READ_* code (< 0)
+ *   if the data ended first.
+ * fraction = if true, a '.' and fractional part are part of the number;
+ *   if false, the number ends at a '.'.
+ * pMantissa, pExponent = receive the number, as *pMantissa * 10^*pExponent.
+ *
+ * Returns true if there were digits, false if there is no number.
+ */
+boolean ESP8266HttpRead::readDigits(int *pCh, boolean fraction,
+    Mantissa *pMantissa, int *pExponent) {
+  int ch = *pCh;
 
-  double result = 0.0;
+  /*
+   * Collect the digits in an integer and convert to double only once, at the end.
+   * Integer arithmetic is much faster than double arithmetic on processors
+   * without double-precision hardware (the AVR, the ESP32, most ARM microcontrollers).
+   * Digits beyond what the integer can hold are too small to matter,
+   * so we only count them (integer part) or ignore them (fractional part).
+   */
+  Mantissa mantissa = 0;
+  int exponent = 0;   // power of 10 to multiply mantissa by.
 
   // Read the integer part of the number (if there is one)
 
-  boolean sawInteger = false;
-  ch = read();
+  boolean sawDigit = false;
   while ('0' <= (char) ch && (char) ch <= '9') {
-    sawInteger = true;
-    result *= 10.0;
-    result += (char) ch - '0';
+    sawDigit = true;
+    if (mantissa <= MANTISSA_MAX) {
+      mantissa = mantissa * 10 + ((char) ch - '0');
+    } else {
+      ++exponent;
+    }
 
     ch = read();
   }
-  if (ch < 0) {
-    return DBL_MAX;    // early end of file or error.
+
+  // read the fractional part of the number (if there is one)
+
+  if (fraction && ch == '.') {
+    ch = read();
+    while ('0' <= (char) ch && (char) ch <= '9') {
+      sawDigit = true;
+      if (mantissa <= MANTISSA_MAX) {
+        mantissa = mantissa * 10 + ((char) ch - '0');
+        --exponent;
+      }
+
+      ch = read();
+    }
+  }
+
+  *pCh = ch;
+  *pMantissa = mantissa;
+  *pExponent = exponent;
+  return sawDigit;
+}
+
+/*
+ * For readNumbers(): skip the delimiters, then read an optionally signed number.
+ *
+ * pCh = points to the first character, already read.
+ *   Receives the character just past the number (see readDigits()).
+ * delimiters = the characters that separate the numbers.
+ * pNegative = receives true if the number has a '-' sign.
+ * pMantissa, pExponent = receive the number, without its sign, as *pMantissa * 10^*pExponent.
+ *
+ * Returns true if a number was read, false if there is no number,
+ * or if the data stopped (e.g., READ_TIMEOUT) just after the digits,
+ * so the number may have been cut short.  A number that ends the body (READ_CLOSED) is read.
+ */
+boolean ESP8266HttpRead::readNumber(int *pCh, const char *delimiters, boolean *pNegative,
+    Mantissa *pMantissa, int *pExponent) {
+  int ch = *pCh;
+
+  while (ch > 0 && strchr(delimiters, ch)) {
+    ch = read();
+  }
+
+  *pNegative = (ch == '-');
+  if (ch == '-' || ch == '+') {
+    ch = read();
+  }
+
+  boolean found = readDigits(&ch, true, pMantissa, pExponent);
+  *pCh = ch;
+  return found && (ch >= 0 || ch == READ_CLOSED);
+}
+
+/*
+ * Store mantissa * 10^exponent in *pValue, for readNumbers().
+ * Integers drop the digits past the decimal point.
+ */
+void ESP8266HttpRead::toNumber(Mantissa mantissa, int exponent, int *pValue) {
+  long value;
+  toNumber(mantissa, exponent, &value);
+  *pValue = (int) value;
+}
+
+void ESP8266HttpRead::toNumber(Mantissa mantissa, int exponent, long *pValue) {
+  while (exponent > 0) {
+    mantissa *= 10;
+    --exponent;
+  }
+  while (exponent < 0) {
+    mantissa /= 10;
+    ++exponent;
+  }
+  *pValue = (long) mantissa;
+}
+
+void ESP8266HttpRead::toNumber(Mantissa mantissa, int exponent, float *pValue) {
+  *pValue = (float) scaleMantissa(mantissa, exponent);
+}
+
+void ESP8266HttpRead::toNumber(Mantissa mantissa, int exponent, double *pValue) {
+  *pValue = scaleMantissa(mantissa, exponent);
+}
+
+/*
+ * Read a JSON value, such as a web API's response body, in one pass:
+ * store the values that fields[] names into a struct, and skip everything else,
+ * without buffering any of it.  For example, for
+ *   {"main":{"temp":21.4,"humidity":55},"weather":[{"description":"haze"}]}
+ * use:
+ *   struct Weather { float temp; int humidity; char description[16]; };
+ *   const ESP8266HttpRead::JsonField WEATHER_FIELDS[] = {
+ *     ESP8266HTTP_JSON_FIELD(Weather, temp, "main.temp"),
+ *     ESP8266HTTP_JSON_FIELD(Weather, humidity, "main.humidity"),
+ *     ESP8266HTTP_JSON_FIELD(Weather, description, "weather.0.description")
+ *   };
+ *   Weather weather;
+ *   ...
+ *   reader.readJson(&weather, WEATHER_FIELDS, 3);
+ *
+ * Each key's path is hashed as its characters arrive, and compared with
+ * the paths' hashes, which the compiler computed.
+ * Members whose paths don't appear, or whose values are of the wrong JSON type
+ * (e.g., a string for an int member), are left as they were.
+ * Strings are truncated to fit their member, and '\0'-terminated.
+ * Numbers are as readNumbers() reads them, with an optional exponent (e.g., 1.5e-3).
+ *
+ * Anything before the first '{' or '[' (e.g., the chunk size of a chunked response)
+ * is skipped.  Reading stops at the end of the JSON value.
+ *
+ * Returns the number of values stored, or a READ_* code if the data ended
+ * before the JSON value did (see ::read()), or READ_ERROR if the data isn't JSON.
+ */
+int ESP8266HttpRead::readJson(void *pStruct, const JsonField *fields, int count) {
+  JsonSchema schema;
+  schema.pStruct = (char *) pStruct;
+  schema.fields = fields;
+  schema.count = count;
+  schema.stored = 0;
+
+  int ch = read();
+  while (ch >= 0 && ch != '{' && ch != '[') {
+    ch = read();
+  }
+
+  int result = readJsonValue(&ch, HASH_START, 0, &schema);
+  if (result < 0) {
+    return result;
   }
-  if (ch != '.') {
-    if (!sawInteger) {
-      return DBL_MAX;   // no number was found at all.
+  return schema.stored;
+}
+
+/*
+ * Part of ::readJson(): read one JSON value, whose path has the given hash.
+ *
+ * pCh = points to the character before the value (or its first), already read.
+ *   Receives the character after the value, if reading the value read it (a number does),
+ *   otherwise ' '.
+ * depth = the number of objects and arrays the value is in.
+ *
+ * Returns 0, or a READ_* code.
+ */
+int ESP8266HttpRead::readJsonValue(int *pCh, uint32_t hash, int depth, JsonSchema *pSchema) {
+  int ch = skipJsonSpace(*pCh);
+  *pCh = ' ';
+
+  if (ch == '{' || ch == '[') {
+    if (depth >= JSON_DEPTH_MAX) {
+      return skipJsonContainer();
+    }
+    if (ch == '{') {
+      return readJsonObject(hash, depth, pSchema);
+    }
+    return readJsonArray(hash, depth, pSchema);
+  }
+
+  // A simple value: see whether it's wanted.
+  const JsonField *pField = pSchema->fields;
+  const JsonField *pEnd = pField + pSchema->count;
+  while (pField < pEnd && pField->hash != hash) {
+    ++pField;
+  }
+  uint8_t type = JSON_STRING;
+  char *pMember = 0;
+  if (pField < pEnd) {
+    type = pField->type;
+    pMember = pSchema->pStruct + pField->offset;
+  }
+
+  if (ch == '"') {
+    if (type != JSON_STRING) {
+      pMember = 0;
+    }
+    int result = readJsonString(pMember, pMember ? pField->size : 0);
+    if (result == 0 && pMember) {
+      ++pSchema->stored;
     }
     return result;
   }
 
-  // read the fractional part of the number (if there is one)
+  if (ch == 't' || ch == 'f' || ch == 'n') {
+    int first = ch;   // true, false or null.
+    while ('a' <= ch && ch <= 'z') {
+      ch = read();
+    }
+    *pCh = ch;
+    if (pMember && type == JSON_BOOL && first != 'n') {
+      *(bool *) pMember = (first == 't');
+      ++pSchema->stored;
+    }
+    return 0;
+  }
 
-  double scale = 0.1;
-  ch = read();
-  while ('0' <= (char) ch && (char) ch <= '9') {
-    sawInteger = true;
-    result += scale * ((char) ch - '0');
-    scale /= 10.0;
+  if (ch != '-' && (ch < '0' || ch > '9')) {
+    return ch < 0 ? ch : READ_ERROR;
+  }
 
+  boolean negative = (ch == '-');
+  if (negative) {
     ch = read();
   }
-  if (ch < 0) {
-    return DBL_MAX;
+  Mantissa mantissa;
+  int exponent;
+  if (!readDigits(&ch, true, &mantissa, &exponent)) {
+    return ch < 0 ? ch : READ_ERROR;
+  }
+  if (ch == 'e' || ch == 'E') {
+    ch = read();
+    boolean negativeExponent = (ch == '-');
+    if (ch == '-' || ch == '+') {
+      ch = read();
+    }
+    int power = 0;
+    while ('0' <= ch && ch <= '9') {
+      if (power < 1000) {
+        power = power * 10 + (ch - '0');
+      }
+      ch = read();
+    }
+    exponent += negativeExponent ? -power : power;
+  }
+  *pCh = ch;
+
+  if (!pMember) {
+    return 0;
   }
-  if (!sawInteger) {
-    return DBL_MAX;
+  switch (type) {
+  case JSON_INT:
+    storeNumber((int *) pMember, negative, mantissa, exponent);
+    break;
+  case JSON_LONG:
+    storeNumber((long *) pMember, negative, mantissa, exponent);
+    break;
+  case JSON_FLOAT:
+    storeNumber((float *) pMember, negative, mantissa, exponent);
+    break;
+  case JSON_DOUBLE:
+    storeNumber((double *) pMember, negative, mantissa, exponent);
+    break;
+  default:
+    return 0;   // not a number member.
   }
+  ++pSchema->stored;
+  return 0;
+}
 
-  return result;
+/*
+ * Part of ::readJson(): read a JSON object, through its '}'.
+ * The '{' has been read.
+ * hash = the hash of the object's path.
+ * Returns 0, or a READ_* code.
+ */
+int ESP8266HttpRead::readJsonObject(uint32_t hash, int depth, JsonSchema *pSchema) {
+  if (depth > 0) {
+    hash = jsonHashNext(hash, '.');
+  }
+
+  int ch = skipJsonSpace(read());
+  if (ch == '}') {
+    return 0;
+  }
+
+  while (true) {
+    if (ch != '"') {
+      return ch < 0 ? ch : READ_ERROR;
+    }
+
+    // Hash the key as it arrives. (An escaped character is hashed as it's written)
+    uint32_t keyHash = hash;
+    while ((ch = read()) != '"') {
+      if (ch == '\\') {
+        ch = read();
+      }
+      if (ch < 0) {
+        return ch;
+      }
+      keyHash = jsonHashNext(keyHash, (char) ch);
+    }
+
+    ch = skipJsonSpace(read());
+    if (ch != ':') {
+      return ch < 0 ? ch : READ_ERROR;
+    }
+    ch = read();
+    int result = readJsonValue(&ch, keyHash, depth + 1, pSchema);
+    if (result < 0) {
+      return result;
+    }
+
+    ch = skipJsonSpace(ch);
+    if (ch == '}') {
+      return 0;
+    }
+    if (ch != ',') {
+      return ch < 0 ? ch : READ_ERROR;
+    }
+    ch = skipJsonSpace(read());
+  }
+}
+
+/*
+ * Part of ::readJson(): read a JSON array, through its ']'.
+ * The '[' has been read.
+ * hash = the hash of the array's path.
+ * Returns 0, or a READ_* code.
+ */
+int ESP8266HttpRead::readJsonArray(uint32_t hash, int depth, JsonSchema *pSchema) {
+  if (depth > 0) {
+    hash = jsonHashNext(hash, '.');
+  }
+
+  int ch = skipJsonSpace(read());
+  if (ch == ']') {
+    return 0;
+  }
+
+  for (unsigned int index = 0; ; ++index) {
+    int result = readJsonValue(&ch, jsonHashIndex(hash, index), depth + 1, pSchema);
+    if (result < 0) {
+      return result;
+    }
+
+    ch = skipJsonSpace(ch);
+    if (ch == ']') {
+      return 0;
+    }
+    if (ch != ',') {
+      return ch < 0 ? ch : READ_ERROR;
+    }
+    ch = read();
+  }
+}
+
+/*
+ * Part of ::readJson(): read a JSON string, through its closing '"'.
+ * The opening '"' has been read.
+ * value[] = receives the string, '\0'-terminated. May be null, to skip the string.
+ * valueSize = the size of value[]. A longer string is truncated.
+ * Returns 0, or a READ_* code.
+ */
+int ESP8266HttpRead::readJsonString(char *value, int valueSize) {
+  int length = 0;
+
+  while (true) {
+    int ch = read();
+    if (ch < 0) {
+      return ch;
+    }
+    if (ch == '"') {
+      break;
+    }
+
+    if (ch == '\\') {
+      ch = read();
+      if (ch < 0) {
+        return ch;
+      }
+      switch (ch) {
+      case 'n':
+        ch = '\n';
+        break;
+      case 'r':
+        ch = '\r';
+        break;
+      case 't':
+        ch = '\t';
+        break;
+      case 'u':
+        {
+          // \uXXXX: store ASCII as itself, anything else as '?'
+          unsigned int code = 0;
+          for (int i = 0; i < 4; ++i) {
+            ch = read();
+            if (ch < 0) {
+              return ch;
+            }
+            code = code * 16 + (isdigit(ch) ? ch - '0' : (tolower(ch) - 'a' + 10) & 0xF);
+          }
+          ch = code < 0x80 ? code : '?';
+        }
+        break;
+      default:
+        break;    // \" \\ \/ are the character itself.
+      }
+    }
+
+    if (value && length < valueSize - 1) {
+      value[length++] = (char) ch;
+    }
+  }
+
+  if (value && valueSize > 0) {
+    value[length] = '\0';
+  }
+  return 0;
+}
+
+/*
+ * Part of ::readJson(): skip a JSON object or array that is nested too deeply
+ * to look into, through its closing '}' or ']'.  The opening '{' or '[' has been read.
+ * Returns 0, or a READ_* code.
+ */
+int ESP8266HttpRead::skipJsonContainer() {
+  int nesting = 1;
+
+  while (nesting > 0) {
+    int ch = read();
+    if (ch < 0) {
+      return ch;
+    }
+    if (ch == '{' || ch == '[') {
+      ++nesting;
+    } else if (ch == '}' || ch == ']') {
+      --nesting;
+    } else if (ch == '"') {
+      int result = readJsonString(0, 0);
+      if (result < 0) {
+        return result;
+      }
+    }
+  }
+  return 0;
+}
+
+/*
+ * Part of ::readJson(): returns the first character, from ch on, that isn't JSON white space.
+ */
+int ESP8266HttpRead::skipJsonSpace(int ch) {
+  while (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n') {
+    ch = read();
+  }
+  return ch;
+}
+
+/*
+ * Part of ::readJson(): adds the given character to the given path hash.
+ * Keys are case-sensitive, unlike header names: see ::hashNext().
+ * (This must match ::jsonHash())
+ */
+uint32_t ESP8266HttpRead::jsonHashNext(uint32_t hash, char ch) {
+  return (hash ^ (uint8_t) ch) * 16777619UL;
+}
+
+/*
+ * Part of ::readJson(): adds the given array index, in decimal, to the given path hash.
+ */
+uint32_t ESP8266HttpRead::jsonHashIndex(uint32_t hash, unsigned int index) {
+  if (index >= 10) {
+    hash = jsonHashIndex(hash, index / 10);
+  }
+  return jsonHashNext(hash, (char) ('0' + index % 10));
+}
+
+/*
+ * Returns the READ_* code for how the data ended.  See ESP8266HttpFilter::status().
+ */
+int ESP8266HttpRead::endCode() {
+  return endCode(_filter.status());
+}
+
+/*
+ * Returns the READ_* code for the given ESP8266HttpFilter::FILTER_* status.
+ */
+int ESP8266HttpRead::endCode(int filterStatus) {
+  switch (filterStatus) {
+  case ESP8266HttpFilter::FILTER_DISCONNECTED:
+    return READ_DISCONNECTED;
+  case ESP8266HttpFilter::FILTER_LINK_ERROR:
+    return READ_LINK_ERROR;
+  default:
+    return READ_CLOSED;
+  }
+}
+
+/*
+ * Returns the READ_* code for how a ::beginFiltered() client's data ended:
+ * the status of the filter that removed the messages, if it's known.
+ */
+int ESP8266HttpRead::filteredEndCode() {
+#if defined(ESP32)
+  if (_pTaskClient) {
+    return endCode(_pTaskClient->status());
+  }
+#endif
+  return READ_CLOSED;
+}
+
+/*
+ * Choose which ESP8266 messages to recognize and remove.
+ * messageMask = the OR of (1 << ESP8266HttpFilter::MSG_*) of each message.
+ *   The default is ESP8266HttpFilter::MSG_DEFAULT.
+ */
+void ESP8266HttpRead::setMessages(uint16_t messageMask) {
+  _messages = messageMask;
+  _filter.setMessages(messageMask);
+}
+
+/*
+ * Set a function to call each time an ESP8266 message is removed from the data.
+ * For example, to log "WIFI DISCONNECT" or "busy p...".
+ * See ESP8266HttpFilter::onMessage().
+ */
+void ESP8266HttpRead::onMessage(ESP8266HttpFilter::MessageHandler pHandler, void *pContext) {
+  _filter.onMessage(pHandler, pContext);
+}
+
+/*
+ * Returns the number of +IPD frames, since ::begin(), that arrived damaged:
+ * their data didn't match the length the ESP8266 gave, usually because
+ * SoftwareSerial's receive buffer overflowed and bytes were lost.
+ * If this isn't 0, don't trust what was read.  Consider asking for less data at a time,
+ * a lower baud rate, or ::beginPassive().
+ * See ESP8266HttpFilter::badFrames().
+ */
+unsigned int ESP8266HttpRead::badFrames() {
+  return _filter.badFrames();
 }
 
 /*
@@ -489,25 +1871,26 @@ double ESP8266HttpRead::readDouble() {
  */
 void ESP8266HttpRead::end() {
   _pEsp8266Client = 0;
+  _ended = false;
 }
 
 /*
- * Part of the command recognition state machine.
- * If the given character has been received, advance to the given state.
- * Otherwise, flush the buffer contents and wait for a command.
+ * Returns mantissa * 10^exponent, for readDouble().
+ * Uses at most one double multiply or divide after building the power of 10.
  */
-void ESP8266HttpRead::advanceIf(char wantChar, byte newState) {
-  if ((char) _cmdBuf[_nextIn] == wantChar) {
-    ++_nextIn;
-    _nextOut = _nextIn;
-    _cmdState = newState;
-    return;
+double ESP8266HttpRead::scaleMantissa(Mantissa mantissa, int exponent) {
+  if (mantissa == 0) {
+    return 0.0;   // even for a huge exponent, whose scale would be infinite (e.g., 0e999).
   }
 
-  // Not found. Reset the search.
-
-  ++_nextIn;
-  _nextOut = 0;
-  _cmdState = CMD_WAIT;
+  double scale = 1.0;
+  int n = exponent < 0 ? -exponent : exponent;
+  while (n-- > 0) {
+    scale *= 10.0;
+  }
 
+  if (exponent < 0) {
+    return (double) mantissa / scale;
+  }
+  return (double) mantissa * scale;
 }
@@ -18,6 +18,13 @@
 #include <Arduino.h>
 #include <SoftwareSerial.h> 
 #include <SparkFunESP8266WiFi.h>
+#include <limits.h> // For ULONG_MAX
+#include <stddef.h> // For offsetof()
+#include "ESP8266HttpFilter.h"
+#include "ESP8266HttpPattern.h"
+
+class ESP8266RingClient;
+class ESP8266TaskClient;
 
 /*
  * The object used to read data from the WiFi shield.
@@ -34,48 +41,83 @@ class ESP8266HttpRead {
   private:
     ESP8266Client *_pEsp8266Client; // The underlying ESP8266 web client
     unsigned long _timeoutMs;       // timeout (milliseconds) per read() call.
+    unsigned long _idleMillis;      // millis() when data last arrived, or read() began waiting for it.
+    long _progress;                 // how far the last sliced function got. See READ_PARTIAL.
+    boolean _partial;               // if true, the last sliced function returned READ_PARTIAL.
+    boolean _ended = false;         // if true, readStatus() drained or aborted the response.
+
+    Stream *_pEsp8266Commands;      // passive mode: where to send AT+CIPRECVDATA. Null in active mode.
+    int _frameBytes;                // passive mode: the number of bytes to ask for at a time.
+    boolean _filtered;              // if true, the client's data has already been filtered.
+    boolean _spanReads;             // if true, the client's read(buf, size) returns the count it read.
+    ESP8266TaskClient *_pTaskClient; // the client, if it's an ESP8266TaskClient, else null.
+
+    ESP8266HttpFilter _filter;      // removes the ESP8266 messages from the data.
+    uint16_t _messages = ESP8266HttpFilter::MSG_DEFAULT; // messages to remove. See setMessages().
 
     /*
-     * CMD_* = state machine state for ESP8266 commands in the input stream.
-     * Designed to recognize and skip "\n+IPD,.*:" and "0,CLOSED"
+     * If no data arrives for this long (milliseconds) while the filter
+     * holds what might be the start of an ESP8266 message, it's data.
      */
-    enum CmdState {
-      CMD_WAIT,  // Waiting for a message from the ESP8266
-      
-      CMD_NL,    // newline (\n) has been received
-      CMD_PLUS,  // \n+ has been received
-      CMD_I,     // \n+I
-      CMD_P,     // \n+IP
-      CMD_D,     // \n+IPD
-      CMD_COMMA, // \n+IPD,
-      // then anything until a colon ends the command
-
-      CMD_0,       // 0 has been received
-      CMD_0_,      // 0,
-      CMD_0_C,     // 0,C
-      CMD_0_CL,    // 0,CL
-      CMD_0_CLO,   // 0,CLO
-      CMD_0_CLOS,  // 0,CLOS
-      CMD_0_CLOSE  // 0,CLOSE
-      // then a D to end the command
-    };
-    
-    byte _cmdState;    // current state of the command-recognition state machine. See CMD_*
-    
-    int _cmdBuf[20];   // Buffer storing a string that might be a command, but might not.
-    int _nextIn = 0;   // index of the next available space in _cmdBuf[]
-    int _nextOut = 0;  // if != _nextIn, index of the next thing to flush from _cmdBuf[]
-
-    void advanceIf(char wantChar, byte newState);
-    
+    static const unsigned long PARTIAL_MESSAGE_MS = 50;
+
+    int endCode();
+    int endCode(int filterStatus);
+    int filteredEndCode();
+    void requestData();
+    int readSome(char *buf, int count);
+    int readWaiting(char *buf, int count);
+    void startSliced();
+    int sliceWait(unsigned long startMillis, unsigned long sliceMs);
+    int skipLine();
+    int skipHeaders(long *pContentLength);
+
+    static const uint32_t HASH_START = 2166136261UL;  // hash of an empty header name or JSON path.
+    static uint32_t hashNext(uint32_t hash, char ch);
+
+    /*
+     * The integer readDigits() collects a number's digits in.
+     * Where a double is wider than a float (e.g., the ESP32), a 32-bit mantissa
+     * would drop digits a double keeps (e.g., of 1700000000123),
+     * so we use 64 bits there and the faster 32 bits where a double is a float (the AVR).
+     */
+#if __SIZEOF_DOUBLE__ > 4
+    typedef unsigned long long Mantissa;
+#else
+    typedef unsigned long Mantissa;
+#endif
+
+    // The largest mantissa readDouble() can add another digit to.
+    static const Mantissa MANTISSA_MAX = ((Mantissa) -1 - 9) / 10;
+
+    boolean readDigits(int *pCh, boolean fraction, Mantissa *pMantissa, int *pExponent);
+    static double scaleMantissa(Mantissa mantissa, int exponent);
+
+    boolean readNumber(int *pCh, const char *delimiters, boolean *pNegative,
+      Mantissa *pMantissa, int *pExponent);
+    static void toNumber(Mantissa mantissa, int exponent, int *pValue);
+    static void toNumber(Mantissa mantissa, int exponent, long *pValue);
+    static void toNumber(Mantissa mantissa, int exponent, float *pValue);
+    static void toNumber(Mantissa mantissa, int exponent, double *pValue);
+
   public:
     /*
      * Return values from ::read().
      */
+    const int READ_PARTIAL = -6;       // the time slice ran out first; call again to continue.
+    const int READ_LINK_ERROR = -5;    // the ESP8266 reported an error (ERROR).
+    const int READ_DISCONNECTED = -4;  // the WiFi connection dropped (WIFI DISCONNECT).
     const int READ_ERROR = -3;         // Error (didn't call begin() before readWithin())
     const int READ_TIMEOUT = -2;       // timeout passed before the byte was received.
     const int READ_CLOSED = -1;        // connection was closed.
 
+    /*
+     * What readStatus() does when the status isn't a success (2xx).
+     */
+    const int ON_ERROR_READ = 0;   // nothing: the caller reads the error response.
+    const int ON_ERROR_DRAIN = 1;  // read and discard the rest of the response.
+    const int ON_ERROR_ABORT = 2;  // close the connection without reading the response.
+
     /*
      * The Date and Time returned from parseDate().
      * I would have used the C++ struct tm, but that didn't seem to be available in the Arduino library.
@@ -91,13 +133,226 @@ class ESP8266HttpRead {
       short second;         // 0..61 (usually 0..59)
     };
 
+    /*
+     * A header for readHeaders() to look for.
+     * Declare each with ESP8266HTTP_HEADER() or ESP8266HTTP_HEADER_HANDLER(),
+     * which leave the fields readHeaders() sets initialized.
+     */
+    struct HttpHeader;
+    typedef void (*HeaderHandler)(HttpHeader *pHeader, void *pContext);
+    struct HttpHeader {
+      const char *name;      // header name, without the ':'. E.g., "Content-Type"
+      char *value;           // receives the header's value, '\0'-terminated. May be null.
+      int valueSize;         // size of value[]. A longer value is truncated.
+      HeaderHandler handler; // if not null, called when the header has been read.
+      void *pContext;        // passed to handler.
+
+      // Set by readHeaders()
+      boolean found;         // if true, the header was found.
+      uint32_t hash;         // hash of name.
+      int nameLength;        // length of name.
+    };
+
+    /*
+     * JSON_* = the type of a struct member that ::readJson() fills.
+     * ESP8266HTTP_JSON_FIELD() chooses it from the member's declaration.
+     */
+    enum JsonType {
+      JSON_INT,     // int
+      JSON_LONG,    // long
+      JSON_FLOAT,   // float
+      JSON_DOUBLE,  // double
+      JSON_BOOL,    // bool, from true or false
+      JSON_STRING   // char[], '\0'-terminated
+    };
+
+    /*
+     * A JSON value for ::readJson() to store, and where to store it.
+     * Declare each with ESP8266HTTP_JSON_FIELD().
+     */
+    struct JsonField {
+      uint32_t hash;    // hash of the value's path. See ::jsonHash().
+      size_t offset;    // offset of the member in the struct.
+      uint8_t type;     // JSON_* type of the member.
+      size_t size;      // size of the member. A longer string is truncated.
+    };
+
+    /*
+     * Returns the hash of the given JSON path, computed by the compiler for a constant path.
+     * (This is the FNV-1a hash, as ::readJson() computes it while reading the keys)
+     */
+    static constexpr uint32_t jsonHash(const char *path, uint32_t hash = HASH_START) {
+      return *path == '\0' ? hash : jsonHash(path + 1, (hash ^ (uint8_t) *path) * 16777619UL);
+    }
+
     boolean begin(ESP8266Client& esp8266Client, unsigned long timeoutMs);
+    boolean begin(ESP8266RingClient& ringClient, unsigned long timeoutMs);
+    boolean beginFiltered(ESP8266Client& esp8266Client, unsigned long timeoutMs);
+#if defined(ESP32)
+    boolean beginFiltered(ESP8266TaskClient& taskClient, unsigned long timeoutMs);
+#endif
+    boolean beginPassive(ESP8266Client& esp8266Client, Stream& esp8266Commands,
+      unsigned long timeoutMs, int frameBytes);
     void end();
+    void setMessages(uint16_t messageMask);
+    void onMessage(ESP8266HttpFilter::MessageHandler pHandler, void *pContext);
+    unsigned int badFrames();
     int read();
     boolean read(char *buf, short count);
-    boolean find(char *ppattern);
+    int readAvailable(char *buf, int count);
+    int read(char *buf, int count, unsigned long sliceMs);
+    int skip(long count, unsigned long sliceMs);
+    int copyTo(Print& sink, unsigned long sliceMs);
+    long progress();
+    int readStatus(int onError);
+    int readBody(char *buf, int bufSize, boolean *pTruncated);
+    boolean find(const char *ppattern);
+    int find(const char *pattern, unsigned long sliceMs);
+
+    /*
+     * Like ::find(const char *), for a pattern declared with ESP8266HTTP_PATTERN()
+     * (see ESP8266HttpPattern.h). E.g., reader.find<HeaderEnd>()
+     * Returns true if the pattern was found, false otherwise (see ::read()).
+     */
+    template<class PATTERN> boolean find() {
+      uint_fast8_t matched = 0;
+      while (matched < PATTERN::length()) {
+        int ch = read();
+        if (ch < 0) {
+          return false;
+        }
+        matched = ESP8266HttpMatcher<PATTERN>::next(matched, (char) ch);
+      }
+      return true;
+    }
+    boolean findHeader(const char *name);
+    boolean readHeaders(HttpHeader *headers, int count);
     boolean findDate(struct HttpDateTime *pDateTimeUTC);
     double readDouble();
+    int readJson(void *pStruct, const JsonField *fields, int count);
+    int readf(const char *format, ...) __attribute__((format(scanf, 2, 3)));
+
+    /*
+     * Read up to maxCount numbers, separated by runs of the characters in delimiters,
+     * into out[], in one call.  E.g., after find("["), to read a JSON array of numbers:
+     *   reader.readNumbers(samples, 500, ", \r\n")
+     * T = int, long, float or double.
+     * decimals = each number is stored times 10^decimals.  For int or long elements,
+     *   that's fixed point: e.g., 21.45 with decimals = 2 is stored as 2145.
+     *   (Digits past that are dropped)
+     * Numbers are optionally signed, and otherwise as readDouble() reads them.
+     *
+     * Reading stops at a character that is neither a delimiter nor a number
+     * (e.g., the ']' of the JSON array), which has been read,
+     * or after maxCount numbers, when the character after the last one has been read,
+     * or at the end of the body.  A number is stored only once the character after it
+     * (or the end of the body) has been read: if the data stops first (e.g., READ_TIMEOUT),
+     * that number, which may be cut short, isn't stored.
+     * Returns the number of numbers stored in out[].
+     */
+    template<class T> int readNumbers(T *out, int maxCount, const char *delimiters,
+        int decimals = 0) {
+      boolean negative;
+      Mantissa mantissa;
+      int exponent;
+
+      if (maxCount <= 0) {
+        return 0;
+      }
+      int ch = read();
+      int count = 0;
+      while (count < maxCount && readNumber(&ch, delimiters, &negative, &mantissa, &exponent)) {
+        toNumber(mantissa, exponent + decimals, &out[count]);
+        if (negative) {
+          out[count] = -out[count];
+        }
+        ++count;
+      }
+      return count;
+    }
+
+  private:
+    int readHeaderBlock(HttpHeader *headers, int count);
+
+    // The most nested objects and arrays ::readJson() looks into. Deeper ones are skipped.
+    static const int JSON_DEPTH_MAX = 8;
+
+    /*
+     * What ::readJson() stores into.
+     */
+    struct JsonSchema {
+      char *pStruct;              // the struct to fill.
+      const JsonField *fields;    // the members to fill.
+      int count;                  // the number of entries in fields[].
+      int stored;                 // the number of values stored so far.
+    };
+
+    int readJsonValue(int *pCh, uint32_t hash, int depth, JsonSchema *pSchema);
+    int readJsonObject(uint32_t hash, int depth, JsonSchema *pSchema);
+    int readJsonArray(uint32_t hash, int depth, JsonSchema *pSchema);
+    int readJsonString(char *value, int valueSize);
+    int skipJsonContainer();
+    int skipJsonSpace(int ch);
+    static uint32_t jsonHashNext(uint32_t hash, char ch);
+    static uint32_t jsonHashIndex(uint32_t hash, unsigned int index);
+
+    // Store the number, negated if negative, into *pValue.
+    template<class T> static void storeNumber(T *pValue, boolean negative,
+        Mantissa mantissa, int exponent) {
+      toNumber(mantissa, exponent, pValue);
+      if (negative) {
+        *pValue = -*pValue;
+      }
+    }
 };
 
+/*
+ * The JSON_* type of each struct member type that ::readJson() can fill.
+ */
+template<class T> struct ESP8266HttpJsonType;
+template<> struct ESP8266HttpJsonType<int> {
+  static const uint8_t TYPE = ESP8266HttpRead::JSON_INT;
+};
+template<> struct ESP8266HttpJsonType<long> {
+  static const uint8_t TYPE = ESP8266HttpRead::JSON_LONG;
+};
+template<> struct ESP8266HttpJsonType<float> {
+  static const uint8_t TYPE = ESP8266HttpRead::JSON_FLOAT;
+};
+template<> struct ESP8266HttpJsonType<double> {
+  static const uint8_t TYPE = ESP8266HttpRead::JSON_DOUBLE;
+};
+template<> struct ESP8266HttpJsonType<bool> {
+  static const uint8_t TYPE = ESP8266HttpRead::JSON_BOOL;
+};
+template<size_t N> struct ESP8266HttpJsonType<char[N]> {
+  static const uint8_t TYPE = ESP8266HttpRead::JSON_STRING;
+};
+
+/*
+ * Declares a ESP8266HttpRead::JsonField: the JSON value at path
+ * is to be stored in the member of the given struct type.
+ * A path is the keys from the outermost object in, separated by '.';
+ * an array element's key is its index, 0 first.  E.g., "weather.0.description"
+ * The member's type must be int, long, float, double, bool or a char array.
+ */
+#define ESP8266HTTP_JSON_FIELD(type, member, path) \
+  { ESP8266HttpRead::jsonHash(path), offsetof(type, member), \
+    ESP8266HttpJsonType<decltype(((type *) 0)->member)>::TYPE, sizeof(((type *) 0)->member) }
+
+/*
+ * Declares a ESP8266HttpRead::HttpHeader: readHeaders() is to store the value
+ * of the header with the given name (without the ':') in value[valueSize].
+ * value may be null, to just learn whether the header was found.
+ */
+#define ESP8266HTTP_HEADER(name, value, valueSize) \
+  { name, value, valueSize, 0, 0, false, 0, 0 }
+
+/*
+ * Like ESP8266HTTP_HEADER(), and readHeaders() is to call handler(pHeader, pContext)
+ * once the header has been read.
+ */
+#define ESP8266HTTP_HEADER_HANDLER(name, value, valueSize, handler, pContext) \
+  { name, value, valueSize, handler, pContext, false, 0, 0 }
+
 #endif // ESP8266HttpRead_h
@@ -0,0 +1,124 @@
+/*
+ * Polls several web servers from one loop(), without waiting on any of them.
+ * See ESP8266HttpScheduler.h for details.
+ *
+ * Copyright (c) 2015 Bradford Needham
+ * (@bneedhamia, https://www.needhamia.com)
+ * Licensed under the LGPL version 3
+ * a version of which should be supplied with this file.
+ */
+#include <Arduino.h>
+#include <SoftwareSerial.h>
+#include <SparkFunESP8266WiFi.h>
+#include "ESP8266HttpScheduler.h"
+
+// (we use the default constructor for ESP8266HttpScheduler)
+
+/*
+ * Set up the servers to poll.  Each is first polled as soon as ::run() gets to it.
+ *
+ * esp8266Client = the ESP8266Client to make the requests with.
+ * endpoints[] = the servers to poll.  Must stay in memory while the scheduler runs.
+ * count = the number of entries in endpoints[].
+ * timeoutMs = time (milliseconds) a whole response may take before it's abandoned.
+ */
+void ESP8266HttpScheduler::begin(ESP8266Client& esp8266Client, Endpoint *endpoints, int count,
+    unsigned long timeoutMs) {
+  _pEsp8266Client = &esp8266Client;
+  _endpoints = endpoints;
+  _endpointCount = count;
+  _timeoutMs = timeoutMs;
+  _active = -1;
+  _next = 0;
+
+  for (int i = 0; i < count; ++i) {
+    _endpoints[i].started = false;
+  }
+}
+
+/*
+ * Do the work that's ready: start requests that are due, and pass the
+ * response data that has arrived to the endpoints' functions.
+ * Call this each time through loop().
+ *
+ * budgetMs = about how long (milliseconds) to work before returning.
+ *   Returns sooner if there's nothing to do.  (One request's start can take longer:
+ *   see StartFunction)
+ */
+void ESP8266HttpScheduler::run(unsigned long budgetMs) {
+  unsigned long startMillis = millis();
+  char buf[64];
+
+  do {
+    if (_active < 0 && !startNext()) {
+      return;   // nothing is due.
+    }
+
+    Endpoint *pEndpoint = &_endpoints[_active];
+    int length = _reader.readAvailable(buf, sizeof(buf));
+    if (length > 0) {
+      if (pEndpoint->onData) {
+        (*pEndpoint->onData)(buf, length, pEndpoint->pContext);
+      }
+    } else if (length < 0) {
+      finish(length);
+    } else if (millis() - pEndpoint->startMillis > _timeoutMs) {
+      _pEsp8266Client->stop();
+      finish(_reader.READ_TIMEOUT);
+    } else {
+      return;   // the response is on its way; do something else meanwhile.
+    }
+  } while (millis() - startMillis < budgetMs);
+}
+
+/*
+ * Returns true if a response is arriving.
+ */
+boolean ESP8266HttpScheduler::isBusy() {
+  return _active >= 0;
+}
+
+/*
+ * Start the request of the next endpoint that is due, taking turns.
+ * Returns true if a request was started, false if none is due.
+ */
+boolean ESP8266HttpScheduler::startNext() {
+  unsigned long now = millis();
+
+  for (int n = 0; n < _endpointCount; ++n) {
+    int i = (_next + n) % _endpointCount;
+    Endpoint *pEndpoint = &_endpoints[i];
+    if (pEndpoint->started && now - pEndpoint->startMillis < pEndpoint->intervalMs) {
+      continue;   // not due yet.
+    }
+
+    _next = (i + 1) % _endpointCount;
+    pEndpoint->started = true;
+    pEndpoint->startMillis = now;
+    _active = i;
+
+    if (!(*pEndpoint->start)(*_pEsp8266Client, pEndpoint->pContext)) {
+      finish(_reader.READ_ERROR);
+      now = millis();
+      continue;
+    }
+
+    _reader.begin(*_pEsp8266Client, _timeoutMs);
+    return true;
+  }
+
+  return false;
+}
+
+/*
+ * The active endpoint's response has ended, with the given READ_* code.
+ */
+void ESP8266HttpScheduler::finish(int result) {
+  Endpoint *pEndpoint = &_endpoints[_active];
+  _active = -1;
+  _reader.end();
+
+  if (pEndpoint->onDone) {
+    (*pEndpoint->onDone)(result, pEndpoint->pContext);
+  }
+}
@@ -0,0 +1,113 @@
+#ifndef ESP8266HttpScheduler_h
+#define ESP8266HttpScheduler_h
+
+/*
+ * Polls several web servers, each at its own interval, from one loop(),
+ * without waiting on any of them: each call to ::run() does at most budgetMs
+ * of work and returns, so a slow server doesn't hold up the rest of the Sketch.
+ * The response data is handed to a function per server as it arrives,
+ * and another function is called when the response is complete or has failed.
+ *
+ * The Shield's connection 0 carries one response at a time
+ * (see ESP8266HttpRead), so the servers take turns, round-robin,
+ * and a server that doesn't answer within timeoutMs is skipped until its next turn.
+ *
+ * To use:
+ *   boolean startWeather(ESP8266Client& client, void *pContext) {
+ *     if (client.connect("api.example.com", 80) <= 0) {
+ *       return false;
+ *     }
+ *     client.print(F("GET /weather HTTP/1.1\r\nHost: api.example.com\r\nConnection: close\r\n\r\n"));
+ *     return true;
+ *   }
+ *   void weatherData(const char *data, int length, void *pContext) { ...parse data[] }
+ *   void weatherDone(int result, void *pContext) { ...result == reader.READ_CLOSED if complete }
+ *
+ *   ESP8266HttpScheduler::Endpoint endpoints[] = {
+ *     ESP8266HTTP_ENDPOINT(60000, startWeather, weatherData, weatherDone, 0),
+ *     ESP8266HTTP_ENDPOINT(5000, startSensor, sensorData, sensorDone, 0)
+ *   };
+ *   ESP8266HttpScheduler scheduler;
+ *
+ *   setup():
+ *     scheduler.begin(client, endpoints, 2, 10000);
+ *   loop():
+ *     scheduler.run(20);
+ *     ...the rest of the Sketch
+ *
+ * Copyright (c) 2015 Bradford Needham
+ * (@bneedhamia, https://www.needhamia.com)
+ * Licensed under the LGPL version 3
+ * a version of which should be supplied with this file.
+ */
+
+#include <Arduino.h>
+#include <SparkFunESP8266WiFi.h>
+#include "ESP8266HttpRead.h"
+
+class ESP8266HttpScheduler {
+  public:
+    /*
+     * Connect to the server and send the request.  Returns true if successful.
+     * (This is the one step that waits: the Sparkfun library waits for the Shield's replies.)
+     */
+    typedef boolean (*StartFunction)(ESP8266Client& esp8266Client, void *pContext);
+
+    /*
+     * Handle the next part of the response: data[0..length-1].
+     * The response arrives a part at a time, in order; the status line and headers are included.
+     */
+    typedef void (*DataFunction)(const char *data, int length, void *pContext);
+
+    /*
+     * The response has ended.
+     * result = ESP8266HttpRead::READ_CLOSED if the whole response arrived,
+     *   READ_TIMEOUT if it took more than timeoutMs, or the READ_* code of the failure
+     *   (READ_ERROR if the StartFunction failed).
+     */
+    typedef void (*DoneFunction)(int result, void *pContext);
+
+    /*
+     * A server to poll, and what to do with its responses.
+     * Declare each with ESP8266HTTP_ENDPOINT(), which leaves the fields
+     * ESP8266HttpScheduler sets initialized.
+     */
+    struct Endpoint {
+      unsigned long intervalMs;  // time (milliseconds) from the start of one request to the next.
+      StartFunction start;       // connects and sends the request.
+      DataFunction onData;       // if not null, called with each part of the response.
+      DoneFunction onDone;       // if not null, called when the response has ended.
+      void *pContext;            // passed to the functions.
+
+      // Set by ESP8266HttpScheduler
+      boolean started;           // if true, startMillis is the time of the last request.
+      unsigned long startMillis; // millis() when the last request started.
+    };
+
+  private:
+    ESP8266Client *_pEsp8266Client; // the client all requests use.
+    ESP8266HttpRead _reader;        // reads the current response.
+    Endpoint *_endpoints;           // the servers to poll.
+    int _endpointCount;             // number of entries in _endpoints[].
+    unsigned long _timeoutMs;       // time (milliseconds) a response may take.
+
+    int _active;                    // index of the endpoint whose response is arriving, or -1.
+    int _next;                      // index of the endpoint to consider first for the next request.
+
+    boolean startNext();
+    void finish(int result);
+
+  public:
+    void begin(ESP8266Client& esp8266Client, Endpoint *endpoints, int count, unsigned long timeoutMs);
+    void run(unsigned long budgetMs);
+    boolean isBusy();
+};
+
+/*
+ * Declares a ESP8266HttpScheduler::Endpoint: poll the server every intervalMs,
+ * calling start, onData and onDone (see Endpoint) with pContext.
+ */
+#define ESP8266HTTP_ENDPOINT(intervalMs, start, onData, onDone, pContext) \
+  { intervalMs, start, onData, onDone, pContext, false, 0 }
+
+#endif // ESP8266HttpScheduler_h
@@ -0,0 +1,108 @@
+/*
+ * An ESP8266Client that reads from a ring buffer filled by a serial receive interrupt.
+ * See ESP8266RingClient.h for details.
+ *
+ * Copyright (c) 2015 Bradford Needham
+ * (@bneedhamia, https://www.needhamia.com)
+ * Licensed under the LGPL version 3
+ * a version of which should be supplied with this file.
+ */
+#include <Arduino.h>
+#include <SparkFunESP8266WiFi.h>
+#include <string.h>  // For memcpy()
+#include "ESP8266RingClient.h"
+
+/*
+ * The indexes are passed between the interrupt routine and the Sketch
+ * with acquire / release ordering: a reader that sees the new _head also sees
+ * the byte stored before it, and ::receive() doesn't reuse a space until the reader
+ * that freed it has finished with it.  On the AVR these are plain byte loads and stores;
+ * on multi-core processors they also order the memory accesses.
+ */
+#define LOAD_ACQUIRE(x) __atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+#define STORE_RELEASE(x, v) __atomic_store_n(&(x), (v), __ATOMIC_RELEASE)
+
+// (we use the default constructor for ESP8266RingClient)
+
+/*
+ * Store a received byte.  Call this from the serial receive interrupt routine.
+ * Returns true if the byte was stored, false if the buffer was full and it was lost
+ * (see ::overflows()).
+ */
+bool ESP8266RingClient::receive(char ch) {
+  uint8_t head = _head;
+  uint8_t next = (head + 1) & (RING_SIZE - 1);
+
+  if (next == LOAD_ACQUIRE(_tail)) {
+    _overflows = _overflows + 1;
+    return false;
+  }
+
+  _ring[head] = ch;
+  STORE_RELEASE(_head, next);
+  return true;
+}
+
+/*
+ * Returns the number of received bytes waiting to be read.
+ */
+int ESP8266RingClient::available() {
+  return (uint8_t) (LOAD_ACQUIRE(_head) - _tail) & (RING_SIZE - 1);
+}
+
+/*
+ * Returns the next received byte, or -1 if none is waiting.
+ */
+int ESP8266RingClient::read() {
+  uint8_t tail = _tail;
+  if (tail == LOAD_ACQUIRE(_head)) {
+    return -1;
+  }
+
+  uint8_t ch = (uint8_t) _ring[tail];
+  STORE_RELEASE(_tail, (uint8_t) ((tail + 1) & (RING_SIZE - 1)));
+  return ch;
+}
+
+/*
+ * Reads up to size of the received bytes into buf[], without waiting.
+ * Copies at most two spans (the buffer may wrap around),
+ * rather than a byte at a time.
+ * Returns the number of bytes stored in buf[].
+ */
+int ESP8266RingClient::read(uint8_t *buf, size_t size) {
+  uint8_t tail = _tail;
+  uint8_t count = (uint8_t) (LOAD_ACQUIRE(_head) - tail) & (RING_SIZE - 1);
+  if (count > size) {
+    count = (uint8_t) size;
+  }
+
+  uint8_t first = RING_SIZE - tail;  // bytes before the end of _ring[]
+  if (first > count) {
+    first = count;
+  }
+  memcpy(buf, &_ring[tail], first);
+  memcpy(&buf[first], _ring, count - first);
+
+  STORE_RELEASE(_tail, (uint8_t) ((tail + count) & (RING_SIZE - 1)));
+  return count;
+}
+
+/*
+ * Returns the next received byte, without removing it, or -1 if none is waiting.
+ */
+int ESP8266RingClient::peek() {
+  uint8_t tail = _tail;
+  if (tail == LOAD_ACQUIRE(_head)) {
+    return -1;
+  }
+  return (uint8_t) _ring[tail];
+}
+
+/*
+ * Returns the number of received bytes lost because the buffer was full.
+ * If this grows, the Sketch isn't reading fast enough for the baud rate.
+ */
+unsigned int ESP8266RingClient::overflows() {
+  return _overflows;
+}
@@ -0,0 +1,65 @@
+#ifndef ESP8266RingClient_h
+#define ESP8266RingClient_h
+
+/*
+ * An ESP8266Client that reads the Shield's output from a ring buffer
+ * filled by a serial receive interrupt, instead of from SoftwareSerial.
+ * SoftwareSerial turns interrupts off for each bit it receives and loses data
+ * whenever the Sketch is busy; a hardware UART whose receive interrupt
+ * stores each byte here loses nothing until the buffer fills.
+ *
+ * The buffer is a single-producer, single-consumer queue:
+ * the interrupt routine only calls ::receive(), the Sketch (through ESP8266HttpRead)
+ * only reads, and neither needs to turn interrupts off.
+ *
+ * Note: on the AVR, HardwareSerial (Serial, Serial1, ...) already receives this way.
+ * Use this class when your Sketch owns the receive interrupt itself.
+ *
+ * To use (for example, on an Arduino Mega with the Shield on Serial1's pins,
+ * and Serial1 otherwise unused):
+ *   ESP8266RingClient client;
+ *
+ *   ISR(USART1_RX_vect) {
+ *     client.receive(UDR1);
+ *   }
+ *   ...connect and send the request as usual, then
+ *   reader.begin(client, 1000);
+ *
+ * Copyright (c) 2015 Bradford Needham
+ * (@bneedhamia, https://www.needhamia.com)
+ * Licensed under the LGPL version 3
+ * a version of which should be supplied with this file.
+ */
+
+#include <Arduino.h>
+#include <SparkFunESP8266WiFi.h>
+
+class ESP8266RingClient : public ESP8266Client {
+  public:
+    /*
+     * Size of the ring buffer, in bytes.  A power of 2, no more than 128,
+     * so that the indexes are single bytes, which the AVR reads and writes atomically.
+     */
+    static const uint8_t RING_SIZE = 128;
+
+  private:
+    /*
+     * _ring[_tail.._head-1] (modulo RING_SIZE) holds the received bytes not yet read.
+     * _head is written only by ::receive(); _tail only by the readers.
+     * One byte of _ring[] is always left empty, so _head == _tail means empty.
+     */
+    char _ring[RING_SIZE];
+    volatile uint8_t _head = 0;      // index of the next space to fill.
+    volatile uint8_t _tail = 0;      // index of the next byte to read.
+    volatile uint16_t _overflows = 0; // number of bytes lost because _ring[] was full.
+
+  public:
+    bool receive(char ch);
+    int available();
+    int read();
+    int read(uint8_t *buf, size_t size);
+    int peek();
+    unsigned int overflows();
+};
+
+#endif // ESP8266RingClient_h
@@ -0,0 +1,206 @@
+/*
+ * ESP32 only: an ESP8266Client that filters the Shield's output in a FreeRTOS task.
+ * See ESP8266TaskClient.h for details.
+ *
+ * Copyright (c) 2015 Bradford Needham
+ * (@bneedhamia, https://www.needhamia.com)
+ * Licensed under the LGPL version 3
+ * a version of which should be supplied with this file.
+ */
+#if defined(ESP32)
+
+#include <Arduino.h>
+#include <SparkFunESP8266WiFi.h>
+#include "ESP8266TaskClient.h"
+
+// (we use the default constructor for ESP8266TaskClient)
+
+/*
+ * Start the task that receives and filters the Http response.
+ * Call this after sending the Http request, and before ESP8266HttpRead::beginFiltered().
+ * From now until ::stopFilter(), only the task may read esp8266Serial.
+ *
+ * esp8266Serial = the serial port the Shield is connected to.
+ * core = the core to run the task on: the one the Sketch doesn't use
+ *   (the Arduino loop() runs on core 1, so usually 0).
+ *
+ * Returns true if successful, false if the task or its buffer couldn't be created.
+ */
+boolean ESP8266TaskClient::startFilter(Stream& esp8266Serial, int core) {
+  stopFilter();
+
+  if (!_buffer) {
+    _buffer = xStreamBufferCreate(BUFFER_SIZE, 1);
+    if (!_buffer) {
+      return false;
+    }
+  }
+  if (!_done) {
+    _done = xSemaphoreCreateBinary();
+    if (!_done) {
+      return false;
+    }
+  }
+  xStreamBufferReset(_buffer);
+
+  _pEsp8266Serial = &esp8266Serial;
+  _filter.begin();
+  _ended = false;
+  _stop = false;
+  _status = ESP8266HttpFilter::FILTER_OK;
+  _peeked = -1;
+
+  if (xTaskCreatePinnedToCore(taskMain, "ESP8266Filter", STACK_SIZE, this,
+      tskIDLE_PRIORITY + 1, &_task, core) != pdPASS) {
+    _task = 0;
+    return false;
+  }
+  return true;
+}
+
+/*
+ * Stop the filtering task, if it's running.
+ * Call this when done reading the response, before using the Shield's serial port again.
+ *
+ * Only this function deletes the task: it asks the task to finish,
+ * waits until the task has (so it isn't deleted partway through reading the serial port
+ * or sending to the buffer), then deletes it.
+ */
+void ESP8266TaskClient::stopFilter() {
+  if (!_task) {
+    return;
+  }
+
+  __atomic_store_n(&_stop, true, __ATOMIC_RELEASE);
+  xSemaphoreTake(_done, portMAX_DELAY);
+  vTaskDelete(_task);
+  _task = 0;
+}
+
+/*
+ * The task: receive and filter the response, then wait for ::stopFilter() to delete it.
+ */
+void ESP8266TaskClient::taskMain(void *pThis) {
+  ESP8266TaskClient *pClient = (ESP8266TaskClient *) pThis;
+
+  pClient->filterAll();
+
+  xSemaphoreGive(pClient->_done);
+  vTaskSuspend(NULL);
+}
+
+/*
+ * Part of the task: pass everything the Shield sends through the filter
+ * and the filtered data to the Sketch, until the filter says the data has ended.
+ */
+void ESP8266TaskClient::filterAll() {
+  char in[64];
+  char out[sizeof(in) + ESP8266HttpFilter::HELD_MAX];
+  unsigned long idleMillis = millis();
+
+  while (!_filter.isClosed() && !__atomic_load_n(&_stop, __ATOMIC_ACQUIRE)) {
+    size_t inCount = 0;
+    while (inCount < sizeof(in) && _pEsp8266Serial->available() > 0) {
+      in[inCount++] = (char) _pEsp8266Serial->read();
+    }
+
+    if (inCount == 0) {
+      if (millis() - idleMillis > PARTIAL_MESSAGE_MS) {
+        _filter.flush();  // what looked like the start of a message was data.
+      }
+    } else {
+      idleMillis = millis();
+    }
+
+    // (with no input, this returns anything the filter has released)
+    size_t outCount = _filter.filter(in, inCount, out, sizeof(out), 0);
+    if (outCount > 0) {
+      // Wait, if need be, for the Sketch to make room (or to stop the task).
+      size_t sent = 0;
+      while (sent < outCount && !__atomic_load_n(&_stop, __ATOMIC_ACQUIRE)) {
+        sent += xStreamBufferSend(_buffer, &out[sent], outCount - sent, pdMS_TO_TICKS(10));
+      }
+    } else if (inCount == 0) {
+      vTaskDelay(1);
+    }
+  }
+
+  _status = _filter.status();
+  __atomic_store_n(&_ended, true, __ATOMIC_RELEASE);
+}
+
+/*
+ * Returns the number of filtered bytes waiting to be read.
+ */
+int ESP8266TaskClient::available() {
+  if (!_buffer) {
+    return 0;
+  }
+  return (int) xStreamBufferBytesAvailable(_buffer) + (_peeked >= 0 ? 1 : 0);
+}
+
+/*
+ * Returns the next filtered byte, or -1 if none is waiting.
+ */
+int ESP8266TaskClient::read() {
+  if (_peeked >= 0) {
+    int ch = _peeked;
+    _peeked = -1;
+    return ch;
+  }
+
+  uint8_t ch;
+  if (!_buffer || xStreamBufferReceive(_buffer, &ch, 1, 0) == 0) {
+    return -1;
+  }
+  return ch;
+}
+
+/*
+ * Reads up to size of the filtered bytes into buf[], without waiting.
+ * Returns the number of bytes stored in buf[].
+ */
+int ESP8266TaskClient::read(uint8_t *buf, size_t size) {
+  size_t count = 0;
+  if (size > 0 && _peeked >= 0) {
+    buf[count++] = (uint8_t) _peeked;
+    _peeked = -1;
+  }
+  if (_buffer) {
+    count += xStreamBufferReceive(_buffer, &buf[count], size - count, 0);
+  }
+  return (int) count;
+}
+
+/*
+ * Returns the next filtered byte, without removing it, or -1 if none is waiting.
+ */
+int ESP8266TaskClient::peek() {
+  if (_peeked < 0) {
+    _peeked = read();
+  }
+  return _peeked;
+}
+
+/*
+ * Returns true until the data has ended and all of it has been read.
+ * See ::status() for how it ended.
+ */
+uint8_t ESP8266TaskClient::connected() {
+  return !__atomic_load_n(&_ended, __ATOMIC_ACQUIRE) || available() > 0;
+}
+
+/*
+ * Returns ESP8266HttpFilter::FILTER_OK until the data has ended,
+ * then the ESP8266HttpFilter::FILTER_* that says why
+ * (e.g., FILTER_CLOSED, for 0,CLOSED).
+ * ESP8266HttpRead::beginFiltered() passes this on as the READ_* code.
+ */
+int ESP8266TaskClient::status() {
+  if (!__atomic_load_n(&_ended, __ATOMIC_ACQUIRE)) {
+    return ESP8266HttpFilter::FILTER_OK;
+  }
+  return _status;
+}
+
+#endif // defined(ESP32)
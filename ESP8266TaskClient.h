@@ -0,0 +1,84 @@
+#ifndef ESP8266TaskClient_h
+#define ESP8266TaskClient_h
+
+/*
+ * ESP32 only: an ESP8266Client that receives and filters the Shield's output
+ * in a FreeRTOS task of its own, on the other core from the Sketch.
+ * The task reads the Shield's serial port, removes the ESP8266 messages
+ * (see ESP8266HttpFilter) and passes the clean Http response through a
+ * FreeRTOS stream buffer to the Sketch, which reads it with ESP8266HttpRead as usual.
+ * So receiving doesn't stop while the Sketch is busy parsing, and parsing
+ * doesn't wait on the serial port.
+ * (On a PC, the tests build it with a std::thread stand-in for FreeRTOS:
+ * see test/stubs/freertos and the TaskClientTest example)
+ *
+ * To use:
+ *   ESP8266TaskClient client;
+ *   ...connect and send the request as usual, then
+ *   client.startFilter(Serial2, 0);     // filter on core 0
+ *   reader.beginFiltered(client, 1000);
+ *   ...read as usual.
+ *   reader.end();
+ *   client.stopFilter();
+ *
+ * Copyright (c) 2015 Bradford Needham
+ * (@bneedhamia, https://www.needhamia.com)
+ * Licensed under the LGPL version 3
+ * a version of which should be supplied with this file.
+ */
+
+#if defined(ESP32)
+
+#include <Arduino.h>
+#include <SparkFunESP8266WiFi.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/stream_buffer.h>
+#include <freertos/semphr.h>
+#include "ESP8266HttpFilter.h"
+
+class ESP8266TaskClient : public ESP8266Client {
+  public:
+    static const size_t BUFFER_SIZE = 2048;   // bytes of filtered data the task can get ahead.
+    static const uint32_t STACK_SIZE = 4096;  // bytes of stack for the task.
+
+  private:
+    /*
+     * If no data arrives for this long (milliseconds) while the filter
+     * holds what might be the start of an ESP8266 message, it's data.
+     * (The same as in ESP8266HttpRead)
+     */
+    static const unsigned long PARTIAL_MESSAGE_MS = 50;
+
+    Stream *_pEsp8266Serial;        // the Shield's serial port. Read only by the task.
+    ESP8266HttpFilter _filter;      // removes the ESP8266 messages. Used only by the task.
+    StreamBufferHandle_t _buffer = 0; // the filtered data, from the task to the Sketch.
+    TaskHandle_t _task = 0;         // the task, or null if it isn't running. Deleted only by ::stopFilter().
+    SemaphoreHandle_t _done = 0;    // given by the task when it has finished.
+    volatile boolean _stop = false; // if true, ::stopFilter() has asked the task to finish.
+
+    /*
+     * The task sets _status, then _ended (with release ordering),
+     * so a reader that sees _ended (with acquire ordering) also sees _status.
+     */
+    volatile boolean _ended = true; // if true, the task has put the last of the data in _buffer.
+    volatile int _status;           // the ESP8266HttpFilter::FILTER_* that ended the data.
+    int _peeked = -1;               // a byte that ::peek() has taken from _buffer, or -1.
+
+    static void taskMain(void *pThis);
+    void filterAll();
+
+  public:
+    boolean startFilter(Stream& esp8266Serial, int core);
+    void stopFilter();
+    int available();
+    int read();
+    int read(uint8_t *buf, size_t size);
+    int peek();
+    uint8_t connected();
+    int status();
+};
+
+#endif // defined(ESP32)
+
+#endif // ESP8266TaskClient_h
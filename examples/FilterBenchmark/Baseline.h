@@ -0,0 +1,14 @@
+/*
+ * Baseline results for FilterBenchmark:
+ * processor cycles per 1000 bytes delivered by the ESP8266,
+ * in BENCH_* order: read(), read(buf), find(), findDate(), readDouble(), find<>(),
+ * readNumbers().
+ * 0 = no baseline: the benchmark reports NEW instead of PASS or FAIL.
+ * The library ships with no baselines, because the numbers can only be
+ * measured under simavr, so until you record them nothing is compared.
+ *
+ * To record them, run baseline.sh --record on the compiled sketch,
+ * which runs it under simavr on an ATmega328P at 16 MHz and writes its BASELINE line here.
+ * The numbers are for that processor only: don't copy them from another board or a host build.
+ */
+const unsigned long BASELINE_CYCLES_PER_KB[] PROGMEM = { 0, 0, 0, 0, 0, 0, 0 };
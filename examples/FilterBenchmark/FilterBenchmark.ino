@@ -0,0 +1,232 @@
+/*
+ * Benchmark of the ESP8266HttpRead library.
+ * Reports the processor cycles per byte that read(), find(), find<>(), findDate(),
+ * readDouble() and readNumbers() take, using a made-up trace of ESP8266 output
+ * (see TraceClient.h) instead of the WiFi Shield, so no Shield or network is needed.
+ *
+ * The numbers from a real board vary a little from run to run
+ * because of interrupts.  For exact, repeatable numbers, run the compiled sketch
+ * under the simavr AVR simulator, which counts every cycle:
+ *   simavr -m atmega328p -f 16000000 FilterBenchmark.ino.elf
+ * (Export the compiled binary from the Arduino IDE to get the .elf file.)
+ *
+ * The output is comma-separated, one line per benchmark:
+ *   BENCH,name,bytes,cycles,cycles per 1000 bytes,baseline cycles per 1000 bytes,verdict
+ * where verdict is PASS, FAIL (more than REGRESSION_PERCENT slower than the baseline)
+ * or NEW (no baseline recorded in Baseline.h, as shipped), followed by a
+ *   RESULT,PASS or RESULT,FAIL
+ * line that a test script can check, and a BASELINE line that can be
+ * pasted into Baseline.h to record the current numbers as the baseline.
+ * baseline.sh does both under simavr: see the comments at its top.
+ *
+ * Copyright (c) 2015 Bradford Needham
+ * (@bneedhamia, https://www.needhamia.com)
+ * Licensed under the LGPL version 3
+ * a version of which should be supplied with this file.
+ */
+
+#include <SoftwareSerial.h>
+#include <SparkFunESP8266WiFi.h>
+#include <ESP8266HttpRead.h>
+#include <float.h>  // For DBL_MAX
+#include "Baseline.h"
+#include "TraceClient.h"
+
+/*
+ * The Http response the benchmarks read.
+ * HEADER = the Http response header.
+ * BODY = a piece of response body, delivered BODY_REPEATS times.
+ * NUMBERS = a body of numbers to parse with readDouble() and readNumbers(),
+ *   delivered NUMBER_REPEATS times.
+ */
+const char HEADER[] PROGMEM =
+  "HTTP/1.1 200 OK\r\n"
+  "Server: Apache\r\n"
+  "Content-Type: text/plain\r\n"
+  "Date: Fri, 21 Aug 2015 22:06:40 GMT\r\n"
+  "\r\n";
+const char BODY[] PROGMEM =
+  "The quick brown fox jumps over the lazy dog. "
+  "Temperature 21.4, Humidity 55, Pressure 1013.2 mb. ";
+const char NUMBERS[] PROGMEM = "1013.25,";
+const int BODY_REPEATS = 100;
+const int NUMBER_REPEATS = 200;
+
+// A string that isn't there, for find() and find<>() to scan the whole body for.
+#define MISSING "No such string"
+ESP8266HTTP_PATTERN(Missing, MISSING);
+ESP8266HTTP_PATTERN(HeaderEnd, "\r\n\r\n");
+
+// +IPD frame sizes: mostly the Shield's usual 1460 bytes, some shorter.
+const int MIN_FRAME = 200;
+const int MAX_FRAME = 1460;
+
+TraceClient client;
+ESP8266HttpRead reader;
+
+/*
+ * BENCH_* = index of each benchmark, in Baseline.h and benchmarkCyclesPerKb[].
+ */
+const int BENCH_READ = 0;
+const int BENCH_READ_BUF = 1;
+const int BENCH_FIND = 2;
+const int BENCH_FIND_DATE = 3;
+const int BENCH_READ_DOUBLE = 4;
+const int BENCH_FIND_PATTERN = 5;
+const int BENCH_READ_NUMBERS = 6;
+const int BENCH_COUNT = 7;
+
+// A benchmark fails if it is more than this percent slower than its baseline.
+const int REGRESSION_PERCENT = 10;
+
+unsigned long startMicros;
+unsigned long benchmarkCyclesPerKb[BENCH_COUNT];
+boolean anyFailed = false;
+
+void setup() {
+  Serial.begin(9600);
+
+  // The trace has an OK line before the response, and the response has no "OK" lines.
+  reader.setMessages(ESP8266HttpFilter::MSG_DEFAULT | (1 << ESP8266HttpFilter::MSG_OK));
+
+  // read(): the whole body.
+  client.begin(HEADER, BODY, BODY_REPEATS, MIN_FRAME, MAX_FRAME, 0);
+  reader.begin(client, 1000);
+  startBenchmark();
+  while (reader.read() >= 0) {
+  }
+  endBenchmark(BENCH_READ, F("read()"), client.delivered());
+
+  // read(buf, count): the whole body, a buffer at a time.
+  char buf[64];
+  client.begin(HEADER, BODY, BODY_REPEATS, MIN_FRAME, MAX_FRAME, 0);
+  reader.begin(client, 1000);
+  startBenchmark();
+  while (reader.read(buf, sizeof(buf))) {
+  }
+  endBenchmark(BENCH_READ_BUF, F("read(buf)"), client.delivered());
+
+  // find(): a string that isn't there, so it scans the whole body.
+  client.begin(HEADER, BODY, BODY_REPEATS, MIN_FRAME, MAX_FRAME, 0);
+  reader.begin(client, 1000);
+  startBenchmark();
+  reader.find(MISSING);
+  endBenchmark(BENCH_FIND, F("find()"), client.delivered());
+
+  // find<>(): the same, with the pattern compiled in.
+  client.begin(HEADER, BODY, BODY_REPEATS, MIN_FRAME, MAX_FRAME, 0);
+  reader.begin(client, 1000);
+  startBenchmark();
+  reader.find<Missing>();
+  endBenchmark(BENCH_FIND_PATTERN, F("find<>()"), client.delivered());
+
+  // findDate(): the Http header.
+  ESP8266HttpRead::HttpDateTime dateTime;
+  client.begin(HEADER, BODY, 1, MIN_FRAME, MAX_FRAME, 0);
+  reader.begin(client, 1000);
+  startBenchmark();
+  if (!reader.findDate(&dateTime)) {
+    Serial.println(F("findDate() failed"));
+  }
+  endBenchmark(BENCH_FIND_DATE, F("findDate()"), client.delivered());
+
+  // readDouble(): a list of numbers.
+  client.begin(HEADER, NUMBERS, NUMBER_REPEATS, MIN_FRAME, MAX_FRAME, 0);
+  reader.begin(client, 1000);
+  reader.findDate(&dateTime);  // Date is the last header line
+  reader.find<HeaderEnd>();     // skip the rest of the header
+  long headerBytes = client.delivered();
+  startBenchmark();
+  int failures = 0;
+  for (int i = 0; i < NUMBER_REPEATS; ++i) {
+    if (reader.readDouble() == DBL_MAX) {
+      ++failures;   // e.g., a Shield message leaked into the data.
+    }
+  }
+  endBenchmark(BENCH_READ_DOUBLE, F("readDouble()"), client.delivered() - headerBytes);
+  if (failures > 0) {
+    Serial.print(F("readDouble() failures: "));
+    Serial.println(failures);
+  }
+
+  // readNumbers(): the same list, as fixed point (hundredths), a buffer of numbers at a time.
+  long samples[20];
+  client.begin(HEADER, NUMBERS, NUMBER_REPEATS, MIN_FRAME, MAX_FRAME, 0);
+  reader.begin(client, 1000);
+  reader.findDate(&dateTime);
+  reader.find<HeaderEnd>();
+  headerBytes = client.delivered();
+  startBenchmark();
+  int count = 0;
+  int length;
+  do {
+    length = reader.readNumbers(samples, 20, ",", 2);
+    count += length;
+  } while (length == 20);
+  endBenchmark(BENCH_READ_NUMBERS, F("readNumbers()"), client.delivered() - headerBytes);
+  if (count != NUMBER_REPEATS || samples[0] != 101325L) {
+    Serial.print(F("readNumbers() read: "));
+    Serial.println(count);
+  }
+
+  reader.end();
+
+  Serial.print(F("RESULT,"));
+  Serial.println(anyFailed ? F("FAIL") : F("PASS"));
+
+  Serial.print(F("BASELINE,{ "));
+  for (int i = 0; i < BENCH_COUNT; ++i) {
+    if (i > 0) {
+      Serial.print(F(", "));
+    }
+    Serial.print(benchmarkCyclesPerKb[i]);
+  }
+  Serial.println(F(" }"));
+}
+
+void loop() {
+}
+
+void startBenchmark() {
+  Serial.flush();  // so the Serial interrupts don't disturb the measurement.
+  startMicros = micros();
+}
+
+/*
+ * Report the cycles taken since startBenchmark(), and compare them to the baseline.
+ * index = BENCH_* index of the benchmark.
+ * name = the name of the function being measured.
+ * bytes = the number of bytes the ESP8266 delivered.
+ */
+void endBenchmark(int index, const __FlashStringHelper *name, long bytes) {
+  unsigned long cycles = (micros() - startMicros) * (F_CPU / 1000000L);
+  if (bytes <= 0) {
+    bytes = 1;  // (the benchmark failed)
+  }
+
+  // cycles * 1000 / bytes, without overflowing.
+  unsigned long cyclesPerKb = (cycles / bytes) * 1000 + (cycles % bytes) * 1000 / bytes;
+  benchmarkCyclesPerKb[index] = cyclesPerKb;
+
+  unsigned long baseline = pgm_read_dword(&BASELINE_CYCLES_PER_KB[index]);
+
+  Serial.print(F("BENCH,"));
+  Serial.print(name);
+  Serial.print(',');
+  Serial.print(bytes);
+  Serial.print(',');
+  Serial.print(cycles);
+  Serial.print(',');
+  Serial.print(cyclesPerKb);
+  Serial.print(',');
+  Serial.print(baseline);
+  Serial.print(',');
+  if (baseline == 0) {
+    Serial.println(F("NEW"));
+  } else if (cyclesPerKb > baseline + baseline / 100 * REGRESSION_PERCENT) {
+    anyFailed = true;
+    Serial.println(F("FAIL"));
+  } else {
+    Serial.println(F("PASS"));
+  }
+}
@@ -0,0 +1,190 @@
+#ifndef TraceClient_h
+#define TraceClient_h
+
+/*
+ * An ESP8266Client that, instead of talking to the WiFi Shield,
+ * delivers a made-up trace of what the Shield would send for a given Http response:
+ *   0,CONNECT and the OK / SEND OK replies to the request,
+ *   then the response split into "\r\n+IPD,0,<length>:" frames,
+ *   then 0,CLOSED
+ * Use it to benchmark or test ESP8266HttpRead without a Shield or network.
+ *
+ * To use:
+ *   TraceClient client;
+ *   client.begin(HEADER, BODY, 1, 1460, 1460, 0);
+ *   reader.begin(client, 1000);
+ *   ...read as usual.
+ *
+ * Copyright (c) 2015 Bradford Needham
+ * (@bneedhamia, https://www.needhamia.com)
+ * Licensed under the LGPL version 3
+ * a version of which should be supplied with this file.
+ */
+
+#include <SparkFunESP8266WiFi.h>
+
+class TraceClient : public ESP8266Client {
+  private:
+    /*
+     * TRACE_* = the part of the trace being delivered.
+     */
+    enum TraceState {
+      TRACE_CONNECT,  // the Shield's replies to connecting and sending the request.
+      TRACE_IPD,      // the +IPD message that starts a frame.
+      TRACE_DATA,     // the response data in the frame.
+      TRACE_CLOSED,   // the 0,CLOSED message.
+      TRACE_END       // nothing more.
+    };
+
+    byte _state;              // the part of the trace being delivered. See TRACE_*
+
+    const char *_pHeader;     // (in PROGMEM) the Http response header to deliver.
+    const char *_pBody;       // (in PROGMEM) the Http response body to deliver.
+    int _headerLength;        // length of _pHeader[]
+    int _bodyLength;          // length of _pBody[]
+    int _nextHeader;          // index of the next byte of _pHeader[] to deliver.
+    int _nextBody;            // index of the next byte of _pBody[] to deliver.
+    long _responseLeft;       // number of response bytes yet to be delivered.
+
+    int _minFrame;            // smallest +IPD frame, in bytes (except the last frame).
+    int _maxFrame;            // largest +IPD frame, in bytes.
+    int _frameLeft;           // number of bytes left in the current frame.
+
+    char _message[20];        // the +IPD message being delivered.
+    const char *_pMessage;    // the next byte of the message to deliver.
+
+    int _bytesPerMs;          // delivery rate. 0 = as fast as the caller can read.
+    unsigned long _startMillis; // millis() when begin() was called.
+    long _delivered;          // number of bytes delivered since begin().
+
+    /*
+     * Start a new +IPD frame, or finish the trace if the response has all been delivered.
+     */
+    void startFrame() {
+      if (_responseLeft <= 0) {
+        _pMessage = "0,CLOSED\r\n";
+        _state = TRACE_CLOSED;
+        return;
+      }
+
+      _frameLeft = (int) random(_minFrame, _maxFrame + 1);
+      if (_frameLeft > _responseLeft) {
+        _frameLeft = (int) _responseLeft;
+      }
+      snprintf(_message, sizeof(_message), "\r\n+IPD,0,%d:", _frameLeft);
+      _pMessage = _message;
+      _state = TRACE_IPD;
+    }
+
+    /*
+     * Returns the next byte of the trace, or -1 if there are no more.
+     */
+    int nextByte() {
+      while (true) {
+        switch (_state) {
+        case TRACE_CONNECT:
+        case TRACE_IPD:
+          if (*_pMessage != '\0') {
+            return (uint8_t) *_pMessage++;
+          }
+          _state = TRACE_DATA;
+          break;
+
+        case TRACE_DATA:
+          if (_frameLeft > 0) {
+            char ch;
+            if (_nextHeader < _headerLength) {
+              ch = pgm_read_byte(&_pHeader[_nextHeader++]);
+            } else {
+              ch = pgm_read_byte(&_pBody[_nextBody++]);
+              if (_nextBody >= _bodyLength) {
+                _nextBody = 0;
+              }
+            }
+            --_frameLeft;
+            --_responseLeft;
+            return (uint8_t) ch;
+          }
+          startFrame();
+          break;
+
+        case TRACE_CLOSED:
+          if (*_pMessage != '\0') {
+            return (uint8_t) *_pMessage++;
+          }
+          _state = TRACE_END;
+          break;
+
+        default:
+          return -1;
+        }
+      }
+    }
+
+  public:
+    /*
+     * Start a new trace.
+     * pHeader = (in PROGMEM) the Http response header, including the blank line.
+     * pBody = (in PROGMEM) the Http response body, or a piece of it.
+     * bodyRepeats = the number of times to deliver pBody[].
+     *   Repeating a short piece of body makes a long response without using much flash.
+     * minFrame, maxFrame = range of +IPD frame sizes. Each frame's size is
+     *   random in that range.  The Shield usually sends 1460-byte frames.
+     * bytesPerMs = how fast the Shield delivers bytes.
+     *   0 = as fast as the caller reads; 11 = about 115200 baud.
+     */
+    void begin(const char *pHeader, const char *pBody, int bodyRepeats,
+        int minFrame, int maxFrame, int bytesPerMs) {
+      _pHeader = pHeader;
+      _pBody = pBody;
+      _headerLength = strlen_P(pHeader);
+      _bodyLength = strlen_P(pBody);
+      _nextHeader = 0;
+      _nextBody = 0;
+      _responseLeft = _headerLength + (long) _bodyLength * bodyRepeats;
+
+      _minFrame = minFrame;
+      _maxFrame = maxFrame;
+      _frameLeft = 0;
+
+      _pMessage = "0,CONNECT\r\n\r\nOK\r\n\r\nSEND OK\r\n";
+      _state = TRACE_CONNECT;
+
+      _bytesPerMs = bytesPerMs;
+      _startMillis = millis();
+      _delivered = 0;
+
+      randomSeed(1);  // so every run delivers the same trace.
+    }
+
+    /*
+     * Returns the number of bytes delivered so far.
+     */
+    long delivered() {
+      return _delivered;
+    }
+
+    int available() {
+      if (_state == TRACE_END) {
+        return 0;
+      }
+      if (_bytesPerMs > 0
+          && (long) (millis() - _startMillis) * _bytesPerMs <= _delivered) {
+        return 0;   // the next byte hasn't "arrived" yet.
+      }
+      return 1;
+    }
+
+    int read() {
+      if (!available()) {
+        return -1;
+      }
+      int ch = nextByte();
+      if (ch >= 0) {
+        ++_delivered;
+      }
+      return ch;
+    }
+};
+
+#endif // TraceClient_h
@@ -0,0 +1,58 @@
+#!/bin/sh
+#
+# Runs FilterBenchmark under the simavr AVR simulator and reports its results,
+# comparing each benchmark with its number in Baseline.h, if it has one.
+# Baseline.h ships without numbers (they can only be measured under simavr),
+# so until you record them this script only reports; once recorded,
+# a slowdown of the library fails the script (or a CI job that runs it).
+#
+# Usage: ./baseline.sh [--record] FilterBenchmark.ino.elf
+#   (Export the compiled binary from the Arduino IDE to get the .elf file,
+#   or: arduino-cli compile -b arduino:avr:uno --output-dir . FilterBenchmark.ino)
+#
+# Exits 0 if no benchmark is more than REGRESSION_PERCENT slower than its baseline
+# (benchmarks with no baseline are reported as NEW), or 1 if any is slower
+# or the sketch didn't finish.
+# --record = write the measured numbers into Baseline.h, making them the baseline.
+#
+# Copyright (c) 2015 Bradford Needham
+# (@bneedhamia, https://www.needhamia.com)
+# Licensed under the LGPL version 3
+# a version of which should be supplied with this file.
+
+record=no
+if [ "$1" = "--record" ]; then
+  record=yes
+  shift
+fi
+if [ $# -ne 1 ]; then
+  echo "usage: $0 [--record] FilterBenchmark.ino.elf" >&2
+  exit 1
+fi
+
+# The sketch never returns from loop(), so stop the simulator once it has had time to finish.
+output=$(timeout 120 simavr -m atmega328p -f 16000000 "$1" 2>&1)
+echo "$output" | grep 'BENCH,'
+
+result=$(echo "$output" | sed -n 's/.*RESULT,\([A-Z]*\).*/\1/p')
+baseline=$(echo "$output" | sed -n 's/.*BASELINE,\({[ 0-9,]*}\).*/\1/p')
+if [ -z "$result" ] || [ -z "$baseline" ]; then
+  echo "FilterBenchmark did not finish" >&2
+  exit 1
+fi
+
+if [ $record = yes ]; then
+  sed -i "s/\(BASELINE_CYCLES_PER_KB\[\] PROGMEM = \){[ 0-9,]*}/\1$baseline/" \
+    "$(dirname "$0")/Baseline.h"
+  echo "Baseline.h: $baseline"
+  exit 0
+fi
+
+if [ "$result" != "PASS" ]; then
+  echo "RESULT,$result" >&2
+  exit 1
+fi
+if echo "$output" | grep -q ',NEW'; then
+  echo "Some benchmarks have no baseline, so weren't checked; run $0 --record to record them" >&2
+fi
+echo "RESULT,PASS"
@@ -0,0 +1,118 @@
+/*
+ * Stress test of ESP8266RingClient's single-producer, single-consumer ring buffer.
+ * A second thread plays the serial receive interrupt, calling receive() as fast as it can,
+ * while the Sketch reads with read() and read(buf, size), checking every byte.
+ * Needs a board with threads (e.g., the ESP32, whose two cores really do run
+ * the threads at once), or a PC: make -C test builds and runs it there
+ * (see test/Makefile).
+ *
+ * The output is one line per check:
+ *   TEST,name,bytes,errors,verdict
+ * followed by a
+ *   RESULT,PASS or RESULT,FAIL
+ * line that a test script can check.
+ *
+ * Copyright (c) 2015 Bradford Needham
+ * (@bneedhamia, https://www.needhamia.com)
+ * Licensed under the LGPL version 3
+ * a version of which should be supplied with this file.
+ */
+
+#include <SparkFunESP8266WiFi.h>
+#include <ESP8266RingClient.h>
+#include <thread>
+
+// The number of bytes the producer thread sends per test.
+const long TEST_BYTES = 50000L;
+
+// The largest read(buf, size) the consumer asks for; more than RING_SIZE, to test the wrap.
+const int MAX_READ = ESP8266RingClient::RING_SIZE + 22;
+
+ESP8266RingClient client;
+boolean anyFailed = false;
+
+void setup() {
+  Serial.begin(9600);
+
+  testRead(F("read()"), false);
+  testRead(F("read(buf)"), true);
+
+  Serial.print(F("RESULT,"));
+  Serial.println(anyFailed ? F("FAIL") : F("PASS"));
+}
+
+void loop() {
+}
+
+/*
+ * The byte the producer sends at the given position in the stream,
+ * a pattern that doesn't repeat every RING_SIZE bytes, so a stale byte is noticed.
+ */
+uint8_t patternAt(long position) {
+  return (uint8_t) (position * 7 + (position >> 8));
+}
+
+/*
+ * Run the producer thread against the Sketch's reads, and report the errors.
+ * name = the name of the test.
+ * useBuf = if true, read with read(buf, size); else a byte at a time with read().
+ */
+void testRead(const __FlashStringHelper *name, boolean useBuf) {
+  // The producer: retry each byte until there's room for it.
+  std::thread producer([]() {
+    for (long i = 0; i < TEST_BYTES; ) {
+      if (client.receive((char) patternAt(i))) {
+        ++i;
+      }
+    }
+  });
+
+  long errors = 0;
+  long position = 0;
+  uint8_t buf[MAX_READ];
+  int size = 1;
+  while (position < TEST_BYTES) {
+    int waiting = client.available();
+    if (waiting >= ESP8266RingClient::RING_SIZE) {
+      ++errors;
+    }
+
+    if (useBuf) {
+      int count = client.read(buf, size);
+      if (count < 0 || count > size) {
+        ++errors;
+        break;
+      }
+      for (int i = 0; i < count; ++i) {
+        if (buf[i] != patternAt(position++)) {
+          ++errors;
+        }
+      }
+      size = size % MAX_READ + 1;  // every size from 1 to MAX_READ, in turn.
+    } else {
+      int ch = client.read();
+      if (ch >= 0 && ch != patternAt(position++)) {
+        ++errors;
+      }
+    }
+  }
+  producer.join();
+
+  if (client.available() != 0) {
+    ++errors;  // bytes the producer never sent.
+  }
+
+  Serial.print(F("TEST,"));
+  Serial.print(name);
+  Serial.print(',');
+  Serial.print(position);
+  Serial.print(',');
+  Serial.print(errors);
+  Serial.print(',');
+  if (errors != 0) {
+    anyFailed = true;
+    Serial.println(F("FAIL"));
+  } else {
+    Serial.println(F("PASS"));
+  }
+}
@@ -0,0 +1,230 @@
+/*
+ * Load test of ESP8266TaskClient (ESP32 only).
+ * A second thread plays the Shield, sending Http responses in +IPD frames
+ * as fast as the serial port (here an ESP8266RingClient) takes them;
+ * the client's task filters them on the other core, and the Sketch reads them
+ * with ESP8266HttpRead, checking every byte and how each response ended.
+ * On a PC, make -C test builds and runs it, with a std::thread stand-in for FreeRTOS
+ * (see test/Makefile).
+ *
+ * The output is one line per check:
+ *   TEST,name,bytes,errors,verdict
+ * followed by a
+ *   RESULT,PASS or RESULT,FAIL
+ * line that a test script can check.
+ *
+ * Copyright (c) 2015 Bradford Needham
+ * (@bneedhamia, https://www.needhamia.com)
+ * Licensed under the LGPL version 3
+ * a version of which should be supplied with this file.
+ */
+
+#include <SparkFunESP8266WiFi.h>
+#include <ESP8266HttpRead.h>
+#include <ESP8266RingClient.h>
+#include <ESP8266TaskClient.h>
+#include <stdio.h>  // For snprintf()
+#include <atomic>
+#include <thread>
+
+// The number of bytes of response data per test.
+const long TEST_BYTES = 100000L;
+
+// The most bytes of data in a +IPD frame, as the Shield sends.
+const int MAX_FRAME = 1460;
+
+ESP8266RingClient shield;  // the Shield's serial port, as the task sees it.
+ESP8266TaskClient client;
+ESP8266HttpRead reader;
+std::atomic<bool> stopShield(false);  // if true, the Shield thread gives up sending.
+boolean anyFailed = false;
+
+void setup() {
+  Serial.begin(9600);
+
+  testResponse(F("read()"), "0,CLOSED\r\n", false, reader.READ_CLOSED);
+  testResponse(F("read(buf)"), "0,CLOSED\r\n", true, reader.READ_CLOSED);
+  testResponse(F("disconnect"), "\r\nWIFI DISCONNECT\r\n", true, reader.READ_DISCONNECTED);
+  testStop();
+
+  Serial.print(F("RESULT,"));
+  Serial.println(anyFailed ? F("FAIL") : F("PASS"));
+}
+
+void loop() {
+}
+
+/*
+ * The response data at the given position: lines of letters and digits,
+ * with nothing that looks like a Shield message.
+ */
+char dataAt(long position) {
+  static const char LINE[] = "abcdefghijklmnopqrstuvwxyz 0123456789\r\n";
+  return LINE[(position * 7 + (position >> 9)) % (sizeof(LINE) - 1)];
+}
+
+/*
+ * Send the given character through the serial port to the task,
+ * waiting for room in the port's buffer, unless the test has given up.
+ */
+void sendChar(char ch) {
+  while (!shield.receive(ch) && !stopShield) {
+    std::this_thread::yield();
+  }
+}
+
+void sendText(const char *text) {
+  while (*text != '\0') {
+    sendChar(*text++);
+  }
+}
+
+/*
+ * Play the Shield: send TEST_BYTES of response data in +IPD frames of varying sizes,
+ * after the request's SEND OK, followed by the given text (how the response ends).
+ */
+void sendResponse(const char *ending) {
+  sendText("\r\nSEND OK\r\n");
+
+  long position = 0;
+  for (int frame = 0; position < TEST_BYTES && !stopShield; ++frame) {
+    long frameBytes = 1 + (frame * 397L) % MAX_FRAME;
+    if (frameBytes > TEST_BYTES - position) {
+      frameBytes = TEST_BYTES - position;
+    }
+
+    char header[24];
+    snprintf(header, sizeof(header), "\r\n+IPD,0,%ld:", frameBytes);
+    sendText(header);
+    for (long i = 0; i < frameBytes; ++i) {
+      sendChar(dataAt(position++));
+    }
+  }
+
+  sendText(ending);
+}
+
+/*
+ * Discard what the task left in the serial port (e.g., the \r\n after 0,CLOSED),
+ * so the next test starts with an empty port.
+ */
+void emptyShield() {
+  while (shield.read() >= 0) {
+  }
+}
+
+/*
+ * Report the result of a test.
+ */
+void report(const __FlashStringHelper *name, long bytes, long errors) {
+  Serial.print(F("TEST,"));
+  Serial.print(name);
+  Serial.print(',');
+  Serial.print(bytes);
+  Serial.print(',');
+  Serial.print(errors);
+  Serial.print(',');
+  if (errors != 0) {
+    anyFailed = true;
+    Serial.println(F("FAIL"));
+  } else {
+    Serial.println(F("PASS"));
+  }
+}
+
+/*
+ * Read a whole response through the task, and report the errors.
+ * name = the name of the test.
+ * ending = the text that ends the response.
+ * useBuf = if true, read with read(buf, count); else a byte at a time with read().
+ * endCode = the READ_* code that the reader should return after the data.
+ */
+void testResponse(const __FlashStringHelper *name, const char *ending, boolean useBuf,
+    int endCode) {
+  stopShield = false;
+  if (!client.startFilter(shield, 0)) {
+    report(name, 0, 1);
+    return;
+  }
+  reader.beginFiltered(client, 1000);
+  std::thread shieldThread(sendResponse, ending);
+
+  long errors = 0;
+  long position = 0;
+  char buf[100];
+  int size = 1;
+  while (position < TEST_BYTES) {
+    if (useBuf) {
+      if (size > TEST_BYTES - position) {
+        size = (int) (TEST_BYTES - position);
+      }
+      if (!reader.read(buf, size)) {
+        ++errors;
+        break;
+      }
+      for (int i = 0; i < size; ++i) {
+        if (buf[i] != dataAt(position++)) {
+          ++errors;
+        }
+      }
+      size = size % (int) sizeof(buf) + 1;  // every size from 1 to sizeof(buf), in turn.
+    } else {
+      int ch = reader.read();
+      if (ch < 0) {
+        ++errors;
+        break;
+      }
+      if (ch != dataAt(position++)) {
+        ++errors;
+      }
+    }
+  }
+  if (reader.read() != endCode) {
+    ++errors;  // extra data, or the wrong ending.
+  }
+
+  stopShield = true;
+  shieldThread.join();
+  reader.end();
+  client.stopFilter();
+  emptyShield();
+
+  report(name, position, errors);
+}
+
+/*
+ * Stop the task in the middle of a response, while it waits for the Sketch
+ * to make room for more data, and report whether it stopped.
+ */
+void testStop() {
+  stopShield = false;
+  if (!client.startFilter(shield, 0)) {
+    report(F("stopFilter()"), 0, 1);
+    return;
+  }
+  reader.beginFiltered(client, 1000);
+  std::thread shieldThread(sendResponse, "0,CLOSED\r\n");
+
+  long errors = 0;
+  long position = 0;
+  for (; position < (long) ESP8266TaskClient::BUFFER_SIZE / 2; ++position) {
+    if (reader.read() != dataAt(position)) {
+      ++errors;
+    }
+  }
+  while (client.available() < (int) ESP8266TaskClient::BUFFER_SIZE / 2) {
+    delay(1);  // until the task has filled its buffer.
+  }
+
+  client.stopFilter();
+  stopShield = true;
+  shieldThread.join();
+  reader.end();
+
+  if (client.status() != ESP8266HttpFilter::FILTER_OK) {
+    ++errors;  // stopping isn't an end of the response.
+  }
+  emptyShield();
+
+  report(F("stopFilter()"), position, errors);
+}
@@ -0,0 +1,283 @@
+/*
+ * Tests of ESP8266HttpFilter:
+ * - messages: removes each message from sample Shield output, and returns the rest;
+ * - traces: filtering random Shield output a byte at a time (::put() and ::get())
+ *   and in random spans (::filter()) gives the same result;
+ * - the compile-time checks of MESSAGES[] reject what they should (the static_asserts below).
+ * Includes ESP8266HttpFilter.cpp, to reach its compile-time functions.
+ *
+ * The output is one line per test:
+ *   TEST,name,cases,errors,verdict
+ * (each error is described on a line of its own before it), followed by a
+ *   RESULT,PASS or RESULT,FAIL
+ * line that a test script can check.
+ *
+ * Copyright (c) 2015 Bradford Needham
+ * (@bneedhamia, https://www.needhamia.com)
+ * Licensed under the LGPL version 3
+ * a version of which should be supplied with this file.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include "../ESP8266HttpFilter.cpp"
+
+/*
+ * isPrefixFree() must reject a list in which one message's text starts with another's,
+ * whichever comes first, and accept one in which none does.
+ */
+static constexpr char PREFIXED[2][TEXT_MAX + 1] = { "\nERROR\r\n", "\nERR" };
+static constexpr char PREFIXED_FIRST[2][TEXT_MAX + 1] = { "\nERR", "\nERROR\r\n" };
+static constexpr char SAME[2][TEXT_MAX + 1] = { "\nERROR\r\n", "\nERROR\r\n" };
+static constexpr char DIFFERENT[2][TEXT_MAX + 1] = { "\nERROR\r\n", "\nERRS" };
+static_assert(!isPrefixFree(PREFIXED, 2), "isPrefixFree() missed a prefix");
+static_assert(!isPrefixFree(PREFIXED_FIRST, 2), "isPrefixFree() missed a prefix");
+static_assert(!isPrefixFree(SAME, 2), "isPrefixFree() missed a duplicate");
+static_assert(isPrefixFree(DIFFERENT, 2), "isPrefixFree() rejected different messages");
+
+static const uint16_t ALL_MESSAGES = (1 << ESP8266HttpFilter::MSG_COUNT) - 1;
+static const uint16_t FRAMING_MESSAGES =
+  (1 << ESP8266HttpFilter::MSG_IPD) | (1 << ESP8266HttpFilter::MSG_CLOSED);
+
+static bool anyFailed = false;
+
+/*
+ * Print a test's result line.
+ */
+static void report(const char *name, int cases, int errors) {
+  printf("TEST,%s,%d,%d,%s\n", name, cases, errors, errors == 0 ? "PASS" : "FAIL");
+  if (errors != 0) {
+    anyFailed = true;
+  }
+}
+
+/*
+ * Returns text with \r and \n spelled out, for printing.
+ */
+static std::string shown(const std::string& text) {
+  std::string result;
+  for (char ch : text) {
+    if (ch == '\r') {
+      result += "\\r";
+    } else if (ch == '\n') {
+      result += "\\n";
+    } else {
+      result += ch;
+    }
+  }
+  return result;
+}
+
+/*
+ * Returns the Shield's +IPD frame of the given data.
+ */
+static std::string frame(const std::string& data) {
+  return "\r\n+IPD,0," + std::to_string(data.size()) + ":" + data;
+}
+
+/*
+ * Filter the given input a byte at a time, as ESP8266HttpRead::read() does,
+ * stopping where the data ends, then flush what the filter holds
+ * (as the reader does when no more data arrives).
+ * Returns the filtered data, and sets *pStatus to the filter's ::status().
+ */
+static std::string filterBytes(const std::string& in, uint16_t messages, int *pStatus) {
+  ESP8266HttpFilter filter;
+  filter.begin();
+  filter.setMessages(messages);
+
+  std::string out;
+  int ch;
+  for (char inCh : in) {
+    int result = filter.put(inCh);
+    while ((ch = filter.get()) >= 0) {
+      out += (char) ch;
+    }
+    if (result < 0) {
+      break;
+    }
+  }
+  if (!filter.isClosed()) {
+    filter.flush();
+    while ((ch = filter.get()) >= 0) {
+      out += (char) ch;
+    }
+  }
+
+  *pStatus = filter.status();
+  return out;
+}
+
+/*
+ * Like filterBytes(), filtering spans of random lengths into buffers of random sizes.
+ */
+static std::string filterSpans(const std::string& in, uint16_t messages, int *pStatus) {
+  ESP8266HttpFilter filter;
+  filter.begin();
+  filter.setMessages(messages);
+
+  std::string out;
+  char buf[64];
+  size_t position = 0;
+  while (!filter.isClosed()) {
+    size_t inCount = 1 + rand() % 50;
+    if (inCount > in.size() - position) {
+      inCount = in.size() - position;
+    }
+    size_t used;
+    size_t outCount = filter.filter(&in[position], inCount, buf, 1 + rand() % sizeof(buf), &used);
+    out.append(buf, outCount);
+    position += used;
+    if (position >= in.size() && outCount == 0) {
+      break;
+    }
+  }
+  if (filter.isClosed()) {
+    size_t outCount;
+    while ((outCount = filter.filter(0, 0, buf, sizeof(buf), 0)) > 0) {
+      out.append(buf, outCount);
+    }
+  } else {
+    filter.flush();
+    int ch;
+    while ((ch = filter.get()) >= 0) {
+      out += (char) ch;
+    }
+  }
+
+  *pStatus = filter.status();
+  return out;
+}
+
+struct MessageCase {
+  std::string in;     // the Shield's output.
+  uint16_t messages;  // the messages to recognize. See ESP8266HttpFilter::setMessages().
+  std::string out;    // the data that should be left.
+  int status;         // the ESP8266HttpFilter::FILTER_* that should end it.
+};
+
+static void testMessages() {
+  const MessageCase CASES[] = {
+    // Framing
+    { frame("hello") + "0,CLOSED\r\n", ESP8266HttpFilter::MSG_DEFAULT,
+      "hello", ESP8266HttpFilter::FILTER_CLOSED },
+    { "abc\n+IPD,3:def\n", ESP8266HttpFilter::MSG_DEFAULT,
+      "abcdef\n", ESP8266HttpFilter::FILTER_OK },
+    { "ab\r\r\n+IPD,3:cd", ESP8266HttpFilter::MSG_DEFAULT,
+      "ab\rcd", ESP8266HttpFilter::FILTER_OK },
+    { "x0,C0,CLOSEDyy", ESP8266HttpFilter::MSG_DEFAULT,
+      "x0,C", ESP8266HttpFilter::FILTER_CLOSED },
+    { "1000 00,0 \r\n", ESP8266HttpFilter::MSG_DEFAULT,
+      "1000 00,0 \r\n", ESP8266HttpFilter::FILTER_OK },
+    { "a\n+IPD,0,00000000000000000000000000000000000000:b", ESP8266HttpFilter::MSG_DEFAULT,
+      "a\n+IPD,0,00000000000000000000000000000000000000:b", ESP8266HttpFilter::FILTER_OK },
+    { "\r\n+IPD,0,1460:\r\n" + frame("abc"), ESP8266HttpFilter::MSG_DEFAULT,
+      "\r\nabc", ESP8266HttpFilter::FILTER_OK },
+
+    // Messages between frames
+    { "0,CONNECT\r\n\r\nOK\r\n\r\nSEND OK\r\n" + frame("hello") + "0,CLOSED",
+      ESP8266HttpFilter::MSG_DEFAULT,
+      "\r\nOK\r\nhello", ESP8266HttpFilter::FILTER_CLOSED },
+    { "0,CONNECT\r\n\r\nOK\r\n\r\nSEND OK\r\n" + frame("hello") + "0,CLOSED",
+      ALL_MESSAGES,
+      "hello", ESP8266HttpFilter::FILTER_CLOSED },
+    { "a\r\nbusy p...\r\nb", ESP8266HttpFilter::MSG_DEFAULT,
+      "ab", ESP8266HttpFilter::FILTER_OK },
+    { "a\r\nWIFI CONNECTED\r\n\r\nWIFI GOT IP\r\nb", ESP8266HttpFilter::MSG_DEFAULT,
+      "ab", ESP8266HttpFilter::FILTER_OK },
+    { "a\r\nWIFI DISCONNECT\r\nb", ESP8266HttpFilter::MSG_DEFAULT,
+      "a", ESP8266HttpFilter::FILTER_DISCONNECTED },
+    { "a\r\nERROR\r\nb", ESP8266HttpFilter::MSG_DEFAULT,
+      "a", ESP8266HttpFilter::FILTER_LINK_ERROR },
+    { "a\r\nERRORS\r\nb", ESP8266HttpFilter::MSG_DEFAULT,
+      "a\r\nERRORS\r\nb", ESP8266HttpFilter::FILTER_OK },
+    { "\r\nSEND OKAY\r\nz", ESP8266HttpFilter::MSG_DEFAULT,
+      "z", ESP8266HttpFilter::FILTER_OK },
+    { "\r\nSEND\r\nz", ESP8266HttpFilter::MSG_DEFAULT,
+      "\r\nSEND\r\nz", ESP8266HttpFilter::FILTER_OK },
+    { "a\r\nbusy p...\r\nb", FRAMING_MESSAGES,
+      "a\r\nbusy p...\r\nb", ESP8266HttpFilter::FILTER_OK },
+
+    // Text inside a frame that looks like a message between frames is data.
+    { frame("line\r\nbusy person here\r\nX") + "0,CLOSED\r\n", ESP8266HttpFilter::MSG_DEFAULT,
+      "line\r\nbusy person here\r\nX", ESP8266HttpFilter::FILTER_CLOSED },
+    { frame("status\r\nERROR\r\nmore") + "0,CLOSED\r\n", ESP8266HttpFilter::MSG_DEFAULT,
+      "status\r\nERROR\r\nmore", ESP8266HttpFilter::FILTER_CLOSED },
+    { frame("n=10,CONNECTS") + "0,CLOSED\r\n", ESP8266HttpFilter::MSG_DEFAULT,
+      "n=10,CONNECTS", ESP8266HttpFilter::FILTER_CLOSED },
+    { frame("abc") + "\r\nbusy p...\r\n" + frame("def\r\nWIFI GOT IP\r\n")
+        + "\r\nWIFI DISCONNECT\r\n", ESP8266HttpFilter::MSG_DEFAULT,
+      "abcdef\r\nWIFI GOT IP\r\n", ESP8266HttpFilter::FILTER_DISCONNECTED },
+  };
+  const int COUNT = sizeof(CASES) / sizeof(CASES[0]);
+
+  int errors = 0;
+  for (int i = 0; i < COUNT; ++i) {
+    int status;
+    std::string out = filterBytes(CASES[i].in, CASES[i].messages, &status);
+    if (out != CASES[i].out || status != CASES[i].status) {
+      printf("[%s] gave [%s] status %d, not [%s] status %d\n",
+        shown(CASES[i].in).c_str(), shown(out).c_str(), status,
+        shown(CASES[i].out).c_str(), CASES[i].status);
+      ++errors;
+    }
+  }
+  report("messages", COUNT, errors);
+}
+
+/*
+ * Returns random Shield output: frames, messages and pieces of them,
+ * and text that looks like them.
+ */
+static std::string randomTrace() {
+  static const char PIECES[] = "\n\r0,+IPDCLOSEabc:123 SEND OKWIFIbusy pERROR";
+
+  std::string trace;
+  int length = rand() % 200;
+  for (int i = 0; i < length; ++i) {
+    int choice = rand() % 10;
+    if (choice == 0) {
+      trace += "\r\n+IPD,0,12:";
+    } else if (choice == 1) {
+      trace += "0,CLO";
+    } else {
+      trace += PIECES[rand() % (sizeof(PIECES) - 1)];
+    }
+  }
+  if (rand() % 3 == 0) {
+    trace += "0,CLOSED";
+  }
+  return trace;
+}
+
+static void testTraces() {
+  const int COUNT = 20000;
+
+  srand(1);
+  int errors = 0;
+  for (int i = 0; i < COUNT; ++i) {
+    std::string trace = randomTrace();
+    uint16_t messages = (i % 2 == 0) ? ESP8266HttpFilter::MSG_DEFAULT : ALL_MESSAGES;
+    int byteStatus;
+    int spanStatus;
+    std::string byBytes = filterBytes(trace, messages, &byteStatus);
+    std::string bySpans = filterSpans(trace, messages, &spanStatus);
+    if (byBytes != bySpans || byteStatus != spanStatus) {
+      if (errors < 3) {
+        printf("[%s] gave [%s] status %d a byte at a time, but [%s] status %d in spans\n",
+          shown(trace).c_str(), shown(byBytes).c_str(), byteStatus,
+          shown(bySpans).c_str(), spanStatus);
+      }
+      ++errors;
+    }
+  }
+  report("traces", COUNT, errors);
+}
+
+int main() {
+  testMessages();
+  testTraces();
+
+  printf("RESULT,%s\n", anyFailed ? "FAIL" : "PASS");
+  return anyFailed ? 1 : 0;
+}
@@ -0,0 +1,304 @@
+/*
+ * Tests of ESP8266HttpRead's parsing, on a PC:
+ * - doubles: readDouble() keeps the digits a double can hold;
+ * - readf(): reads the numbers a format names, and rejects integers that are too big;
+ * - readNumbers(): stores each number only once the character after it, or the end of the body,
+ *   has arrived;
+ * - JSON numbers: readJson() stores numbers such as 0e999 and 1.5e3;
+ * - headers: readHeaders() stores the headers asked for, in any letter case;
+ * - time-sliced: copyTo() and skip() report their progress, and keep the final count.
+ *
+ * The output is one line per test:
+ *   TEST,name,cases,errors,verdict
+ * (each error is described on a line of its own before it), followed by a
+ *   RESULT,PASS or RESULT,FAIL
+ * line that a test script can check.
+ *
+ * Copyright (c) 2015 Bradford Needham
+ * (@bneedhamia, https://www.needhamia.com)
+ * Licensed under the LGPL version 3
+ * a version of which should be supplied with this file.
+ */
+#include <Arduino.h>
+#include <stdio.h>
+#include <float.h>
+#include <math.h>
+#include <string>
+#include "ESP8266HttpRead.h"
+
+/*
+ * A client whose data is the given text, all of it available at once.
+ * When the text runs out, it stays connected and has no more data,
+ * as the Shield does while the next packet is on its way.
+ */
+class TextClient : public ESP8266Client {
+  private:
+    const char *_text;
+    boolean _closes;
+
+  public:
+    /*
+     * closes = if true, the connection closes once the text has been read,
+     *   as the Shield's does at the end of a response (see ESP8266HttpRead::beginFiltered()).
+     */
+    TextClient(const char *text, boolean closes = false) : _text(text), _closes(closes) {}
+    virtual int available() { return (int) strlen(_text); }
+    virtual int read() { return *_text ? (uint8_t) *_text++ : -1; }
+    virtual int peek() { return *_text ? (uint8_t) *_text : -1; }
+    virtual uint8_t connected() { return !_closes || *_text; }
+};
+
+/*
+ * A sink that keeps what is written to it.
+ */
+class TextSink : public Print {
+  public:
+    std::string text;
+    virtual size_t write(uint8_t ch) { text += (char) ch; return 1; }
+    using Print::write;
+};
+
+static bool anyFailed = false;
+
+/*
+ * Print a test's result line.
+ */
+static void report(const char *name, int cases, int errors) {
+  printf("TEST,%s,%d,%d,%s\n", name, cases, errors, errors == 0 ? "PASS" : "FAIL");
+  if (errors != 0) {
+    anyFailed = true;
+  }
+}
+
+struct DoubleCase {
+  const char *in;
+  double value;     // what readDouble() should return.
+};
+
+static void testDoubles() {
+  const DoubleCase CASES[] = {
+    { "34,", 34.0 },
+    { "15.,", 15.0 },
+    { "90.54,", 90.54 },
+    { ".2,", 0.2 },
+    { "1700000000123,", 1700000000123.0 },
+    { "12345678901.25,", 12345678901.25 },
+    { "4294967296,", 4294967296.0 },
+    { "123456789012345678901234,", 123456789012345678901234.0 },
+    { "0.000000000000000000001,", 1e-21 },
+    { "x,", DBL_MAX },
+    { "12", DBL_MAX },   // the data ends just after the number.
+  };
+  const int COUNT = sizeof(CASES) / sizeof(CASES[0]);
+
+  int errors = 0;
+  for (int i = 0; i < COUNT; ++i) {
+    TextClient client(CASES[i].in);
+    ESP8266HttpRead reader;
+    reader.begin(client, 0);
+    double value = reader.readDouble();
+    // Allow for the rounding of a different order of operations.
+    if (fabs(value - CASES[i].value) > fabs(CASES[i].value) * 1e-15) {
+      printf("readDouble() of [%s] gave %.17g, not %.17g\n", CASES[i].in, value, CASES[i].value);
+      ++errors;
+    }
+  }
+  report("readDouble()", COUNT, errors);
+}
+
+static void testReadf() {
+  int errors = 0;
+  int count = 0;
+
+  TextClient client("T=21.45;H=55;N=-7;B=4294967295;");
+  ESP8266HttpRead reader;
+  reader.begin(client, 0);
+  double t;
+  unsigned int h;
+  int n;
+  unsigned long b;
+  int stored = reader.readf("T=%lf;H=%u;N=%d;B=%lu;", &t, &h, &n, &b);
+  ++count;
+  if (stored != 4 || t != 21.45 || h != 55 || n != -7 || b != 4294967295UL) {
+    printf("readf() gave %d: %g %u %d %lu\n", stored, t, h, n, b);
+    ++errors;
+  }
+
+  // An integer too big for an unsigned long isn't stored.
+  TextClient bigClient("B=123456789012345678901;");
+  reader.begin(bigClient, 0);
+  b = 0;
+  stored = reader.readf("B=%lu;", &b);
+  ++count;
+  if (stored != 0 || b != 0) {
+    printf("readf() of a too-big integer gave %d: %lu\n", stored, b);
+    ++errors;
+  }
+
+  report("readf()", count, errors);
+}
+
+struct NumbersCase {
+  const char *in;
+  boolean closes;     // if true, the body ends with the text; else the data just stops.
+  int count;          // the count readNumbers() should return.
+  long values[4];     // the values it should store, in hundredths.
+};
+
+static void testReadNumbers() {
+  const NumbersCase CASES[] = {
+    { "1, -2,3.75 ,\r\n +4.5]", false, 4, { 100, -200, 375, 450 } },
+    { "1,2,3]", true, 3, { 100, 200, 300 } },
+    { "1,2,3", true, 3, { 100, 200, 300 } },
+    { "1,2,3", false, 2, { 100, 200 } },
+    { "1,2,-", true, 2, { 100, 200 } },
+    { "1,2,3.", false, 2, { 100, 200 } },
+  };
+  const int COUNT = sizeof(CASES) / sizeof(CASES[0]);
+
+  int errors = 0;
+  for (int i = 0; i < COUNT; ++i) {
+    TextClient client(CASES[i].in, CASES[i].closes);
+    ESP8266HttpRead reader;
+    reader.beginFiltered(client, 0);
+    long values[4] = { 0, 0, 0, 0 };
+    int count = reader.readNumbers(values, 4, ", \r\n", 2);
+    boolean same = (count == CASES[i].count);
+    for (int j = 0; j < count && same; ++j) {
+      same = (values[j] == CASES[i].values[j]);
+    }
+    if (!same) {
+      printf("readNumbers() of [%s] gave %d: %ld %ld %ld %ld\n", CASES[i].in, count,
+        values[0], values[1], values[2], values[3]);
+      ++errors;
+    }
+  }
+  report("readNumbers()", COUNT, errors);
+}
+
+struct Numbers {
+  double zero;
+  double big;
+  double scaled;
+  long whole;
+};
+
+static const ESP8266HttpRead::JsonField NUMBER_FIELDS[] = {
+  ESP8266HTTP_JSON_FIELD(Numbers, zero, "zero"),
+  ESP8266HTTP_JSON_FIELD(Numbers, big, "big"),
+  ESP8266HTTP_JSON_FIELD(Numbers, scaled, "scaled"),
+  ESP8266HTTP_JSON_FIELD(Numbers, whole, "whole"),
+};
+
+static void testJson() {
+  int errors = 0;
+
+  TextClient client(
+    "{\"zero\": 0e999, \"big\": 1700000000123, \"scaled\": 1.5e3, \"whole\": 12e2} ");
+  ESP8266HttpRead reader;
+  reader.begin(client, 0);
+  Numbers numbers = { -1, -1, -1, -1 };
+  int stored = reader.readJson(&numbers, NUMBER_FIELDS, 4);
+  if (stored != 4 || numbers.zero != 0.0 || numbers.big != 1700000000123.0
+      || numbers.scaled != 1500.0 || numbers.whole != 1200) {
+    printf("readJson() gave %d: %g %.17g %g %ld\n", stored,
+      numbers.zero, numbers.big, numbers.scaled, numbers.whole);
+    ++errors;
+  }
+
+  report("readJson()", 1, errors);
+}
+
+/*
+ * For testHeaders(): counts the calls.
+ */
+static void countHeader(ESP8266HttpRead::HttpHeader *, void *pContext) {
+  ++*(int *) pContext;
+}
+
+static void testHeaders() {
+  int errors = 0;
+
+  TextClient client(
+    "Date: Mon, 12 Oct 2015 18:03:04 GMT\r\n"
+    "content-type: text/html\r\n"
+    "X-Caf\xe9: latte\r\n"
+    "Server: test\r\n"
+    "\r\n"
+    "body");
+  ESP8266HttpRead reader;
+  reader.begin(client, 0);
+  char type[8];
+  char cafe[8];
+  int calls = 0;
+  ESP8266HttpRead::HttpHeader headers[] = {
+    ESP8266HTTP_HEADER("Content-Type", type, sizeof(type)),
+    ESP8266HTTP_HEADER("X-CAF\xe9", cafe, sizeof(cafe)),
+    ESP8266HTTP_HEADER_HANDLER("Server", 0, 0, countHeader, &calls),
+    ESP8266HTTP_HEADER("Location", 0, 0),
+  };
+  boolean ended = reader.readHeaders(headers, 4);
+  if (!ended || !headers[0].found || strcmp(type, "text/ht") != 0
+      || !headers[1].found || strcmp(cafe, "latte") != 0
+      || !headers[2].found || calls != 1 || headers[3].found
+      || reader.read() != 'b') {
+    printf("readHeaders() gave %d: %d [%s] %d [%s] %d %d %d\n", ended,
+      headers[0].found, type, headers[1].found, cafe, headers[2].found, calls, headers[3].found);
+    ++errors;
+  }
+
+  report("readHeaders()", 1, errors);
+}
+
+static void testSliced() {
+  int errors = 0;
+
+  // A slice of 0 ms copies only what has arrived, so each call copies
+  // at most the reader's buffer-full.
+  static const char BODY[] = "0123456789abcdefghijklmnopqrstuvwxyz0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+  const long BODY_LENGTH = sizeof(BODY) - 1;
+  TextClient client(BODY, true);
+  ESP8266HttpRead reader;
+  reader.beginFiltered(client, 1000);
+  TextSink sink;
+  int result;
+  int calls = 0;
+  long lastProgress = 0;
+  while ((result = reader.copyTo(sink, 0)) == reader.READ_PARTIAL) {
+    ++calls;
+    if (reader.progress() != (long) sink.text.size() || reader.progress() < lastProgress) {
+      printf("copyTo() progress %ld after %d bytes\n", reader.progress(), (int) sink.text.size());
+      ++errors;
+    }
+    lastProgress = reader.progress();
+  }
+  if (result != reader.READ_CLOSED || sink.text != BODY || calls < 2
+      || reader.progress() != BODY_LENGTH) {
+    printf("copyTo() gave %d after %d calls: [%s] progress %ld\n",
+      result, calls, sink.text.c_str(), reader.progress());
+    ++errors;
+  }
+
+  // The next time-sliced function starts from 0.
+  TextClient skipClient(BODY, true);
+  reader.beginFiltered(skipClient, 1000);
+  if (reader.skip(10, 0) != 0 || reader.progress() != 10
+      || reader.skip(5, 0) != 0 || reader.progress() != 5 || reader.read() != 'f') {
+    printf("skip() progress %ld\n", reader.progress());
+    ++errors;
+  }
+
+  report("time-sliced", 2, errors);
+}
+
+int main() {
+  testDoubles();
+  testReadf();
+  testReadNumbers();
+  testJson();
+  testHeaders();
+  testSliced();
+
+  printf("RESULT,%s\n", anyFailed ? "FAIL" : "PASS");
+  return anyFailed ? 1 : 0;
+}
@@ -0,0 +1,21 @@
+/*
+ * Host build of the RingClientTest example sketch (examples/RingClientTest):
+ * runs its two-thread test of ESP8266RingClient on a PC.
+ *
+ * Copyright (c) 2015 Bradford Needham
+ * (@bneedhamia, https://www.needhamia.com)
+ * Licensed under the LGPL version 3
+ * a version of which should be supplied with this file.
+ */
+#include <Arduino.h>
+
+// (the Arduino IDE generates these declarations for the sketch)
+void testRead(const __FlashStringHelper *name, boolean useBuf);
+uint8_t patternAt(long position);
+
+#include "../examples/RingClientTest/RingClientTest.ino"
+
+int main() {
+  setup();
+  return anyFailed ? 1 : 0;
+}
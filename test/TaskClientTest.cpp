@@ -0,0 +1,29 @@
+/*
+ * Host build of the TaskClientTest example sketch (examples/TaskClientTest):
+ * runs its load test of ESP8266TaskClient on a PC, with the std::thread stand-in
+ * for FreeRTOS in stubs/freertos.
+ *
+ * Copyright (c) 2015 Bradford Needham
+ * (@bneedhamia, https://www.needhamia.com)
+ * Licensed under the LGPL version 3
+ * a version of which should be supplied with this file.
+ */
+#include <Arduino.h>
+
+// (the Arduino IDE generates these declarations for the sketch)
+char dataAt(long position);
+void sendChar(char ch);
+void sendText(const char *text);
+void sendResponse(const char *ending);
+void emptyShield();
+void report(const __FlashStringHelper *name, long bytes, long errors);
+void testResponse(const __FlashStringHelper *name, const char *ending, boolean useBuf,
+  int endCode);
+void testStop();
+
+#include "../examples/TaskClientTest/TaskClientTest.ino"
+
+int main() {
+  setup();
+  return anyFailed ? 1 : 0;
+}
@@ -0,0 +1,104 @@
+/*
+ * Host stand-in for the Arduino core.  See Arduino.h for details.
+ *
+ * Copyright (c) 2015 Bradford Needham
+ * (@bneedhamia, https://www.needhamia.com)
+ * Licensed under the LGPL version 3
+ * a version of which should be supplied with this file.
+ */
+#include <stdio.h>
+#include <chrono>
+#include <thread>
+#include "Arduino.h"
+
+HardwareSerial Serial;
+
+static const std::chrono::steady_clock::time_point START = std::chrono::steady_clock::now();
+
+unsigned long millis() {
+  return (unsigned long) std::chrono::duration_cast<std::chrono::milliseconds>(
+    std::chrono::steady_clock::now() - START).count();
+}
+
+unsigned long micros() {
+  return (unsigned long) std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now() - START).count();
+}
+
+void delay(unsigned long ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+long random(long min, long max) {
+  return min + rand() % (max - min);
+}
+
+void randomSeed(unsigned long seed) {
+  srand((unsigned int) seed);
+}
+
+size_t Print::write(const uint8_t *buf, size_t size) {
+  for (size_t i = 0; i < size; ++i) {
+    write(buf[i]);
+  }
+  return size;
+}
+
+size_t Print::print(const char *s) {
+  return write((const uint8_t *) s, strlen(s));
+}
+
+size_t Print::print(const __FlashStringHelper *s) {
+  return print((const char *) s);
+}
+
+size_t Print::print(char ch) {
+  return write((uint8_t) ch);
+}
+
+size_t Print::print(int value) {
+  return print((long) value);
+}
+
+size_t Print::print(unsigned int value) {
+  return print((unsigned long) value);
+}
+
+size_t Print::print(long value) {
+  char text[24];
+  snprintf(text, sizeof(text), "%ld", value);
+  return print(text);
+}
+
+size_t Print::print(unsigned long value) {
+  char text[24];
+  snprintf(text, sizeof(text), "%lu", value);
+  return print(text);
+}
+
+size_t Print::print(double value, int digits) {
+  char text[48];
+  snprintf(text, sizeof(text), "%.*f", digits, value);
+  return print(text);
+}
+
+size_t Print::println() {
+  return print("\r\n");
+}
+
+size_t Print::println(double value, int digits) {
+  size_t length = print(value, digits);
+  return length + println();
+}
+
+size_t HardwareSerial::write(uint8_t ch) {
+  return fwrite(&ch, 1, 1, stdout);
+}
+
+size_t HardwareSerial::write(const uint8_t *buf, size_t size) {
+  return fwrite(buf, 1, size, stdout);
+}
+
+void HardwareSerial::flush() {
+  fflush(stdout);
+}
@@ -0,0 +1,95 @@
+#ifndef Arduino_h
+#define Arduino_h
+
+/*
+ * Host stand-in for the parts of the Arduino core that the library and its tests use,
+ * so they can be built and run on a PC (see ../Makefile).
+ * Flash (PROGMEM) is ordinary memory, and Serial writes to stdout.
+ *
+ * Copyright (c) 2015 Bradford Needham
+ * (@bneedhamia, https://www.needhamia.com)
+ * Licensed under the LGPL version 3
+ * a version of which should be supplied with this file.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define F_CPU 16000000L
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#define pgm_read_word(p) (*(const uint16_t *)(p))
+#define pgm_read_dword(p) (*(const uint32_t *)(p))
+#define strlen_P strlen
+
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper *>(s))
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+class Print {
+  public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t ch) = 0;
+    virtual size_t write(const uint8_t *buf, size_t size);
+
+    size_t print(const char *s);
+    size_t print(const __FlashStringHelper *s);
+    size_t print(char ch);
+    size_t print(int value);
+    size_t print(unsigned int value);
+    size_t print(long value);
+    size_t print(unsigned long value);
+    size_t print(double value, int digits = 2);
+    size_t println();
+    template<class T> size_t println(T value) {
+      size_t length = print(value);
+      return length + println();
+    }
+    size_t println(double value, int digits);
+};
+
+class Stream : public Print {
+  public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    virtual void flush() {}
+};
+
+class Client : public Stream {
+  public:
+    virtual int connect(const char *host, uint16_t port) = 0;
+    virtual int read(uint8_t *buf, size_t size) = 0;
+    virtual void stop() = 0;
+    virtual uint8_t connected() = 0;
+    using Stream::read;
+};
+
+// Serial writes to stdout and never receives anything.
+class HardwareSerial : public Stream {
+  public:
+    void begin(unsigned long) {}
+    size_t write(uint8_t ch);
+    size_t write(const uint8_t *buf, size_t size);
+    int available() { return 0; }
+    int read() { return -1; }
+    int peek() { return -1; }
+    void flush();
+};
+
+extern HardwareSerial Serial;
+
+#endif // Arduino_h
@@ -0,0 +1,228 @@
+/*
+ * Host stand-in for the ESP32's FreeRTOS, built on std::thread and std::mutex.
+ * See freertos/FreeRTOS.h for details.
+ *
+ * Copyright (c) 2015 Bradford Needham
+ * (@bneedhamia, https://www.needhamia.com)
+ * Licensed under the LGPL version 3
+ * a version of which should be supplied with this file.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/stream_buffer.h"
+#include "freertos/semphr.h"
+
+/*
+ * Wait on changed, with lock held, until isDone() or ticksToWait ticks have passed.
+ * Returns isDone().
+ */
+template<class F>
+static bool waitFor(std::unique_lock<std::mutex>& lock, std::condition_variable& changed,
+    TickType_t ticksToWait, F isDone) {
+  if (ticksToWait == portMAX_DELAY) {
+    changed.wait(lock, isDone);
+    return true;
+  }
+  return changed.wait_for(lock, std::chrono::milliseconds(ticksToWait), isDone);
+}
+
+// Stops the program: the code under test used FreeRTOS in a way the ESP32 wouldn't allow.
+static void fail(const char *pMessage) {
+  fprintf(stderr, "FreeRTOS stand-in: %s\n", pMessage);
+  abort();
+}
+
+/*
+ * Tasks.
+ */
+
+// How long vTaskDelete() waits for another task to suspend itself.
+static const TickType_t DELETE_WAIT_TICKS = 5000;
+
+struct HostTask {
+  std::thread thread;
+  std::mutex lock;
+  std::condition_variable changed;
+  bool suspended = false;  // if true, the task is waiting in vTaskSuspend(NULL).
+  bool deleted = false;    // if true, vTaskDelete() has deleted the task.
+};
+
+// Thrown in a task's thread to end it, unwinding its stack, when the task is deleted.
+struct HostTaskDeleted {};
+
+static thread_local HostTask *pCurrentTask = 0;
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t pCode, const char *, uint32_t,
+    void *pParameters, UBaseType_t, TaskHandle_t *pCreatedTask, BaseType_t) {
+  HostTask *pTask = new HostTask();
+  if (pCreatedTask) {
+    *pCreatedTask = pTask;
+  }
+  pTask->thread = std::thread([pTask, pCode, pParameters]() {
+    pCurrentTask = pTask;
+    try {
+      pCode(pParameters);
+    } catch (HostTaskDeleted&) {
+      return;
+    }
+    fail("a task returned instead of deleting itself");
+  });
+  return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task) {
+  if (!task || task == pCurrentTask) {
+    throw HostTaskDeleted();
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(task->lock);
+    if (!waitFor(lock, task->changed, DELETE_WAIT_TICKS, [task]() { return task->suspended; })) {
+      fail("vTaskDelete() of a task that is still running");
+    }
+    task->deleted = true;
+  }
+  task->changed.notify_all();
+  task->thread.join();
+  delete task;
+}
+
+void vTaskSuspend(TaskHandle_t task) {
+  if (task && task != pCurrentTask) {
+    fail("vTaskSuspend() of another task isn't supported");
+  }
+  HostTask *pTask = pCurrentTask;
+  if (!pTask) {
+    fail("vTaskSuspend(NULL) outside a task");
+  }
+
+  std::unique_lock<std::mutex> lock(pTask->lock);
+  pTask->suspended = true;
+  pTask->changed.notify_all();
+  pTask->changed.wait(lock, [pTask]() { return pTask->deleted; });
+  lock.unlock();
+  throw HostTaskDeleted();
+}
+
+void vTaskDelay(TickType_t ticks) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+/*
+ * Stream buffers.
+ */
+
+struct HostStreamBuffer {
+  std::mutex lock;
+  std::condition_variable changed;
+  std::deque<uint8_t> data;
+  size_t size;  // the most bytes data may hold.
+};
+
+StreamBufferHandle_t xStreamBufferCreate(size_t bufferSize, size_t) {
+  HostStreamBuffer *pBuffer = new HostStreamBuffer();
+  pBuffer->size = bufferSize;
+  return pBuffer;
+}
+
+void vStreamBufferDelete(StreamBufferHandle_t buffer) {
+  delete buffer;
+}
+
+/*
+ * As in FreeRTOS, waits (up to ticksToWait) for room for all the data,
+ * then sends as much as there is room for.
+ */
+size_t xStreamBufferSend(StreamBufferHandle_t buffer, const void *pData, size_t length,
+    TickType_t ticksToWait) {
+  std::unique_lock<std::mutex> lock(buffer->lock);
+  waitFor(lock, buffer->changed, ticksToWait, [buffer, length]() {
+    return buffer->size - buffer->data.size() >= length;
+  });
+
+  size_t count = buffer->size - buffer->data.size();
+  if (count > length) {
+    count = length;
+  }
+  const uint8_t *p = (const uint8_t *) pData;
+  buffer->data.insert(buffer->data.end(), p, p + count);
+  buffer->changed.notify_all();
+  return count;
+}
+
+/*
+ * Waits (up to ticksToWait) for any data, then receives up to length bytes.
+ */
+size_t xStreamBufferReceive(StreamBufferHandle_t buffer, void *pData, size_t length,
+    TickType_t ticksToWait) {
+  std::unique_lock<std::mutex> lock(buffer->lock);
+  waitFor(lock, buffer->changed, ticksToWait, [buffer]() { return !buffer->data.empty(); });
+
+  size_t count = buffer->data.size();
+  if (count > length) {
+    count = length;
+  }
+  uint8_t *p = (uint8_t *) pData;
+  for (size_t i = 0; i < count; ++i) {
+    p[i] = buffer->data.front();
+    buffer->data.pop_front();
+  }
+  buffer->changed.notify_all();
+  return count;
+}
+
+size_t xStreamBufferBytesAvailable(StreamBufferHandle_t buffer) {
+  std::lock_guard<std::mutex> lock(buffer->lock);
+  return buffer->data.size();
+}
+
+BaseType_t xStreamBufferReset(StreamBufferHandle_t buffer) {
+  std::lock_guard<std::mutex> lock(buffer->lock);
+  buffer->data.clear();
+  buffer->changed.notify_all();
+  return pdPASS;
+}
+
+/*
+ * Binary semaphores.
+ */
+
+struct HostSemaphore {
+  std::mutex lock;
+  std::condition_variable changed;
+  bool given = false;
+};
+
+SemaphoreHandle_t xSemaphoreCreateBinary() {
+  return new HostSemaphore();
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore) {
+  delete semaphore;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticksToWait) {
+  std::unique_lock<std::mutex> lock(semaphore->lock);
+  if (!waitFor(lock, semaphore->changed, ticksToWait, [semaphore]() { return semaphore->given; })) {
+    return pdFALSE;
+  }
+  semaphore->given = false;
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+  std::lock_guard<std::mutex> lock(semaphore->lock);
+  if (semaphore->given) {
+    return pdFALSE;
+  }
+  semaphore->given = true;
+  semaphore->changed.notify_all();
+  return pdTRUE;
+}
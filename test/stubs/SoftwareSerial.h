@@ -0,0 +1,16 @@
+#ifndef SoftwareSerial_h
+#define SoftwareSerial_h
+
+/*
+ * Host stand-in for the Arduino SoftwareSerial library, which the library includes
+ * but doesn't use directly.
+ *
+ * Copyright (c) 2015 Bradford Needham
+ * (@bneedhamia, https://www.needhamia.com)
+ * Licensed under the LGPL version 3
+ * a version of which should be supplied with this file.
+ */
+
+#include <Arduino.h>
+
+#endif // SoftwareSerial_h
@@ -0,0 +1,36 @@
+#ifndef SparkFunESP8266WiFi_h
+#define SparkFunESP8266WiFi_h
+
+/*
+ * Host stand-in for the Sparkfun ESP8266 WiFi Shield library's ESP8266Client:
+ * a client with no connection and no data.  Tests subclass it, as the library's
+ * own clients (e.g., ESP8266RingClient) do, to supply the Shield's output.
+ * Like the real one, read(buf, size) returns 0 whatever it reads.
+ *
+ * Copyright (c) 2015 Bradford Needham
+ * (@bneedhamia, https://www.needhamia.com)
+ * Licensed under the LGPL version 3
+ * a version of which should be supplied with this file.
+ */
+
+#include <Arduino.h>
+
+class ESP8266Client : public Client {
+  public:
+    virtual int connect(const char *, uint16_t) { return 0; }
+    virtual size_t write(uint8_t) { return 1; }
+    virtual int available() { return 0; }
+    virtual int read() { return -1; }
+    virtual int read(uint8_t *buf, size_t size) {
+      for (size_t i = 0; i < size && available() > 0; ++i) {
+        buf[i] = (uint8_t) read();
+      }
+      return 0;
+    }
+    virtual int peek() { return -1; }
+    virtual void stop() {}
+    virtual uint8_t connected() { return available() > 0; }
+    using Print::write;
+};
+
+#endif // SparkFunESP8266WiFi_h
@@ -0,0 +1,33 @@
+#ifndef FreeRTOS_h
+#define FreeRTOS_h
+
+/*
+ * Host stand-in for the parts of the ESP32's FreeRTOS that ESP8266TaskClient uses,
+ * built on std::thread and std::mutex (see ../FreeRTOS.cpp), so the task and the
+ * Sketch really do run at once on a PC.  A tick is a millisecond.
+ *
+ * Copyright (c) 2015 Bradford Needham
+ * (@bneedhamia, https://www.needhamia.com)
+ * Licensed under the LGPL version 3
+ * a version of which should be supplied with this file.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE ((BaseType_t) 0)
+#define pdTRUE ((BaseType_t) 1)
+#define pdFAIL pdFALSE
+#define pdPASS pdTRUE
+
+#define portMAX_DELAY ((TickType_t) 0xffffffffUL)
+#define portTICK_PERIOD_MS ((TickType_t) 1)
+#define pdMS_TO_TICKS(ms) ((TickType_t) (ms))
+
+#define tskIDLE_PRIORITY ((UBaseType_t) 0)
+
+#endif // FreeRTOS_h
@@ -0,0 +1,26 @@
+#ifndef stream_buffer_h
+#define stream_buffer_h
+
+/*
+ * Host stand-in for FreeRTOS stream buffers: a byte queue guarded by a std::mutex.
+ *
+ * Copyright (c) 2015 Bradford Needham
+ * (@bneedhamia, https://www.needhamia.com)
+ * Licensed under the LGPL version 3
+ * a version of which should be supplied with this file.
+ */
+
+#include "FreeRTOS.h"
+
+typedef struct HostStreamBuffer *StreamBufferHandle_t;
+
+StreamBufferHandle_t xStreamBufferCreate(size_t bufferSize, size_t triggerLevel);
+void vStreamBufferDelete(StreamBufferHandle_t buffer);
+size_t xStreamBufferSend(StreamBufferHandle_t buffer, const void *pData, size_t length,
+  TickType_t ticksToWait);
+size_t xStreamBufferReceive(StreamBufferHandle_t buffer, void *pData, size_t length,
+  TickType_t ticksToWait);
+size_t xStreamBufferBytesAvailable(StreamBufferHandle_t buffer);
+BaseType_t xStreamBufferReset(StreamBufferHandle_t buffer);
+
+#endif // stream_buffer_h
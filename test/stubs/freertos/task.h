@@ -0,0 +1,28 @@
+#ifndef task_h
+#define task_h
+
+/*
+ * Host stand-in for FreeRTOS tasks: each task is a std::thread.
+ * A thread can't be killed, so vTaskDelete() of another task waits until
+ * that task has suspended itself (vTaskSuspend(NULL)), and stops the program
+ * if it doesn't, since on the ESP32 the task would be deleted wherever it was.
+ *
+ * Copyright (c) 2015 Bradford Needham
+ * (@bneedhamia, https://www.needhamia.com)
+ * Licensed under the LGPL version 3
+ * a version of which should be supplied with this file.
+ */
+
+#include "FreeRTOS.h"
+
+typedef struct HostTask *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *pParameters);
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t pCode, const char *pName,
+  uint32_t stackDepth, void *pParameters, UBaseType_t priority,
+  TaskHandle_t *pCreatedTask, BaseType_t coreId);
+void vTaskDelete(TaskHandle_t task);
+void vTaskSuspend(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+
+#endif // task_h